@@ -0,0 +1,62 @@
+
+#ifndef BEAT_QUEUE_H_
+#define BEAT_QUEUE_H_
+
+#include "stm32l4xx_hal.h"
+#include <stdbool.h>
+
+#define BEAT_QUEUE_SIZE 16 // Number of beats kept for the consumers, more than 5 seconds at 200 BPM. A power of 2.
+
+// How a beat was found.
+typedef enum {
+  PT_DETECTION_PRIMARY = 0,  // Above threshold 1 of the integrator and of the filtered signal.
+  PT_DETECTION_SEARCH_BACK   // Found again by the back search with threshold 2, after an RR interval was missed.
+                             // Can't occur yet: the back search is disabled in signal_processing.c, and it doesn't
+                             // locate the R peak or match the template either, those would have to be added first.
+} pt_detection_path_t;
+
+// Shape of a beat, compared to the template of the dominant beat of its lead.
+typedef enum {
+  PT_MORPHOLOGY_UNKNOWN = 0, // The template hasn't formed yet.
+  PT_MORPHOLOGY_DOMINANT,    // Like the template.
+  PT_MORPHOLOGY_ABERRANT     // Different, e.g. a ventricular ectopic beat or a bundle branch block.
+} pt_morphology_t;
+
+// A detected beat.
+typedef struct {
+  uint32_t sample_index;         // Index of the sample the beat was detected on.
+  uint32_t r_peak_q8;            // Refined position of the R peak, in 1/256 samples, see pt_result_t.
+  uint32_t rr_interval_us;       // Time from the previous R peak in microseconds, 0 if not known.
+  uint16_t rr_average;           // Average of the recent RR intervals, in samples.
+  uint8_t evaluation;            // 1 regular, 2 irregular, 0 not evaluated yet.
+  int16_t amplitude;             // Amplitude of the R peak in the DC blocked signal, ADC counts. Negative for a
+                                 // negative R wave.
+  pt_detection_path_t detection_path;
+  int16_t template_score;        // Correlation with the template of the dominant beat, Q15.
+  pt_morphology_t morphology;
+  uint8_t lead;                  // The lead that detected the beat first.
+} pt_beat_event_t;
+
+// The beats are broadcast to any number of consumers, each reading them at its own rate through its own cursor.
+// The queue never blocks the detector: a consumer that fell more than BEAT_QUEUE_SIZE beats behind loses the oldest
+// ones, and is told how many.
+typedef struct {
+  pt_beat_event_t events[BEAT_QUEUE_SIZE];
+  uint32_t pushed;  // Number of beats pushed since the reset, the next one goes to pushed % BEAT_QUEUE_SIZE.
+} pt_beat_queue_t;
+
+// Read position of a consumer.
+typedef struct {
+  uint32_t read;     // Number of beats read or skipped by the consumer.
+  uint32_t dropped;  // Number of beats overwritten before the consumer could read them.
+} pt_beat_cursor_t;
+
+void reset_beat_queue(pt_beat_queue_t* queue);
+
+void push_beat_event(pt_beat_queue_t* queue, const pt_beat_event_t* event);
+
+void attach_beat_cursor(const pt_beat_queue_t* queue, pt_beat_cursor_t* cursor);
+
+bool next_beat_event(const pt_beat_queue_t* queue, pt_beat_cursor_t* cursor, pt_beat_event_t* event);
+
+#endif /* BEAT_QUEUE_H_ */
@@ -0,0 +1,56 @@
+
+#ifndef BEAT_TEMPLATE_H_
+#define BEAT_TEMPLATE_H_
+
+#include "stm32l4xx_hal.h"
+#include <stdbool.h>
+
+#define TEMPLATE_LENGTH 32     // 160ms around the R peak, the QRS complex. Even, the samples are read in pairs.
+
+#define TEMPLATE_BEFORE_R 18   // Samples of the template before the R peak, the part after it has to be filtered
+                               // already when the beat is detected, see signal_processing.c.
+
+#define TEMPLATE_MAX_SHIFT 2   // A beat is aligned to the template by up to this many samples either way.
+
+#define TEMPLATE_SEGMENT_LENGTH (TEMPLATE_LENGTH + 2 * TEMPLATE_MAX_SHIFT) // Samples of a beat to be matched, the R
+                                                                           // peak at TEMPLATE_MAX_SHIFT +
+                                                                           // TEMPLATE_BEFORE_R.
+
+#define TEMPLATE_SAMPLE_SHIFT 2 // The segments are taken from the DC blocked signal shifted right by this much, so the
+                                // sums of products of a window fit in 32 bits.
+
+#define TEMPLATE_SCORE_ONE 32767 // The correlation scores are Q15.
+
+#define TEMPLATE_DOMINANT_SCORE ((int16_t) (0.9 * TEMPLATE_SCORE_ONE)) // A beat at least this similar to the template
+                                                                      // is a dominant beat, and is averaged into it.
+
+#define TEMPLATE_NOISE_SCORE ((int16_t) (0.5 * TEMPLATE_SCORE_ONE)) // A detection less similar to the template than
+                                                                   // this, either way, is noise rather than a beat.
+
+// Ensemble average of the dominant beat of a lead.
+typedef struct {
+  int32_t sum[TEMPLATE_LENGTH];     // The average, scaled up by 2^TEMPLATE_AVERAGE_SHIFT.
+  int16_t samples[TEMPLATE_LENGTH]; // The average, rounded.
+  int32_t samples_sum;              // Sum of the samples and of their squares, for the normalization.
+  int32_t samples_energy;
+  uint16_t beat_count;              // Number of beats averaged so far, 0 if there is no template yet.
+  uint8_t mismatch_count;           // Number of consecutive beats not matching the template, rejected or not.
+} pt_beat_template_t;
+
+// Result of matching a beat against the template.
+typedef struct {
+  int16_t score;  // Normalized cross-correlation, Q15, -1 to 1.
+  int8_t shift;   // Offset of the best aligned window in the segment, relative to the centered one.
+} pt_template_match_t;
+
+void reset_beat_template(pt_beat_template_t* beat_template);
+
+bool is_beat_template_ready(const pt_beat_template_t* beat_template);
+
+void match_beat_template(const pt_beat_template_t* beat_template, const int16_t* segment, pt_template_match_t* match);
+
+void update_beat_template(pt_beat_template_t* beat_template, const int16_t* segment, const pt_template_match_t* match);
+
+void reject_beat_template_candidate(pt_beat_template_t* beat_template);
+
+#endif /* BEAT_TEMPLATE_H_ */
@@ -2,6 +2,8 @@
 #ifndef INC_DISPLAY_H_
 #define INC_DISPLAY_H_
 
+#include <stdbool.h>
+
 #define BUTTON_PRESS 0
 #define RIGHT_TURN 1
 #define LEFT_TURN 2
@@ -25,6 +27,8 @@ void display_handle_rotary_change(int32_t value);
 
 void display_handle_button_press();
 
+void display_handle_lead_off(bool leads_off);
+
 void display_shutdown();
 
 #endif /* INC_DISPLAY_H_ */
@@ -0,0 +1,33 @@
+
+#ifndef INC_DISPLAY_FILTER_H_
+#define INC_DISPLAY_FILTER_H_
+
+#include "stm32l4xx_hal.h"
+#include "signal_processing.h"
+
+#define DISPLAY_FILTER_DELAY (SAMPLING_FREQUENCY * 2 / 5) // Delay of the output, in samples: the baseline removal
+                                                          // looks ahead 400ms.
+
+// Bandwidth of the displayed trace. The detector has its own band-pass filter, tuned for finding the QRS complexes,
+// which distorts the morphology too much to be shown.
+typedef enum {
+  DISPLAY_FILTER_MONITOR = 0, // 0.5 - 40 Hz, a steady trace for watching the rhythm.
+  DISPLAY_FILTER_DIAGNOSTIC,  // 0.05 Hz up to the Nyquist frequency, keeps the ST segment and the T wave intact.
+  DISPLAY_FILTER_PROFILE_COUNT
+} display_filter_profile_t;
+
+// Optional notch filter on the mains frequency.
+typedef enum {
+  DISPLAY_NOTCH_OFF = 0,
+  DISPLAY_NOTCH_50HZ,
+  DISPLAY_NOTCH_60HZ,
+  DISPLAY_NOTCH_COUNT
+} display_filter_notch_t;
+
+void display_filter_select(display_filter_profile_t profile, display_filter_notch_t notch);
+
+void display_filter_reset();
+
+int16_t display_filter_process(uint16_t sample);
+
+#endif /* INC_DISPLAY_FILTER_H_ */
@@ -0,0 +1,30 @@
+
+#ifndef DSP_SIMD_H_
+#define DSP_SIMD_H_
+
+#include <stdint.h>
+
+// The packed 16 bit instructions of the Cortex-M4 DSP extension used by the template matching. On the target they
+// are the CMSIS intrinsics, elsewhere (the host tools) they are emulated in C with the same results, so the kernel
+// can be checked against a reference on a PC.
+// A 32 bit word holds two signed 16 bit lanes, lane 0 in the bottom and lane 1 in the top halfword.
+
+#if defined(__ARM_FEATURE_DSP) && (__ARM_FEATURE_DSP == 1)
+
+#include "cmsis_compiler.h"
+
+#else
+
+#define DSP_SIMD_EMULATED
+
+#define DSP_LANE0(x) ((int32_t) (int16_t) ((x) & 0xFFFF))
+#define DSP_LANE1(x) ((int32_t) (int16_t) ((x) >> 16))
+
+// Sum of the products of the lanes, added to the 32 bit accumulator.
+static inline uint32_t __SMLAD(uint32_t op1, uint32_t op2, uint32_t op3) {
+  return (uint32_t) (DSP_LANE0(op1) * DSP_LANE0(op2) + DSP_LANE1(op1) * DSP_LANE1(op2) + (int32_t) op3);
+}
+
+#endif
+
+#endif /* DSP_SIMD_H_ */
@@ -25,6 +25,7 @@ extern "C" {
 
 #define __SPI_MAX_DELAY__    HAL_MAX_DELAY
 #define __SPI_TX_BLOCK_MAX__ (1U * 1024U) // 1024 16-bit words (2 KiB)
+#define __SPI_TX_FILL_MAX__  (65535U)      // 16-bit words per DMA fill (CNDTR)
 
 // ------------------------------------------------------------------- macros --
 
@@ -156,6 +157,17 @@ typedef enum
 }
 ili9341_spi_slave_t;
 
+typedef enum
+{
+  iisNONE = -1,
+  iisReset,         // = 0, reset line held low
+  iisSoftwareReset, // = 1, waiting for the software reset to complete
+  iisSleepOut,      // = 2, waiting for the sleep-out to complete
+  iisReady,         // = 3
+  iisCOUNT          // = 4
+}
+ili9341_init_state_t;
+
 typedef void (*ili9341_touch_callback_t)(ili9341_t *, uint16_t, uint16_t);
 
 typedef HAL_StatusTypeDef ili9341_status_t;
@@ -174,6 +186,28 @@ struct ili9341
   ili9341_screen_orientation_t orientation;
   ili9341_two_dimension_t      screen_size;
 
+  ili9341_init_state_t init_state;
+  uint32_t             init_tick;
+  uint32_t             init_delay;
+
+  // address window last sent to the TFT, see ili9341_ll_set_window()
+  uint16_t window_x0;
+  uint16_t window_x1;
+  uint16_t window_y0;
+  uint16_t window_y1;
+
+  // solid fill in progress, see ili9341_transmit_fill(). the DMA reads the
+  // color from here, and is restarted from the completion interrupt until
+  // no words remain.
+  uint16_t          fill_color;
+  volatile uint32_t fill_remaining;
+
+  // vertical scrolling area, in frame memory lines, see ili9341_scroll_define().
+  // scroll_size is 0 while the whole screen is fixed.
+  uint16_t scroll_top;
+  uint16_t scroll_size;
+  uint16_t scroll_offset;
+
   GPIO_TypeDef *touch_select_port;
   uint16_t      touch_select_pin;
   GPIO_TypeDef *touch_irq_port;
@@ -213,6 +247,14 @@ ili9341_t *ili9341_new(
     ili9341_touch_support_t   touch_support,
     ili9341_touch_normalize_t touch_normalize);
 
+ili9341_bool_t ili9341_initialize_step(ili9341_t *lcd);
+
+ili9341_bool_t ili9341_scroll_define(ili9341_t *lcd, uint16_t x, uint16_t w);
+void ili9341_scroll_stop(ili9341_t *lcd);
+void ili9341_scroll_rewind(ili9341_t *lcd);
+uint16_t ili9341_scroll_column(ili9341_t *lcd);
+void ili9341_scroll_advance(ili9341_t *lcd);
+
 void ili9341_touch_interrupt(ili9341_t *lcd);
 ili9341_touch_pressed_t ili9341_touch_pressed(ili9341_t *lcd);
 
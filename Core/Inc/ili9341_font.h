@@ -22,7 +22,8 @@ extern "C" {
 
 // ------------------------------------------------------------------- macros --
 
-/* nothing */
+#define __ILI9341_AA_RUN_LEVEL(run)  ((uint8_t)(run) >> 6U)
+#define __ILI9341_AA_RUN_LENGTH(run) (((uint8_t)(run) & 0x3FU) + 1U)
 
 // ----------------------------------------------------------- exported types --
 
@@ -34,12 +35,28 @@ typedef struct
 }
 ili9341_font_t;
 
+// anti-aliased font, 2 bits of coverage per pixel (0 is the background, 3 the
+// foreground). the pixels of a glyph are run-length encoded in raster order,
+// a byte per run: the coverage in the top 2 bits, the length - 1 below them.
+// generated by Tools/ili9341_fontgen.
+typedef struct
+{
+    const uint8_t width;
+    const uint8_t height;
+    char const *chars;      // the characters of the glyphs, in order
+    uint16_t const *offset; // first run of each glyph, and the end of the last
+    uint8_t const *data;
+}
+ili9341_aa_font_t;
+
 // ------------------------------------------------------- exported variables --
 
 extern ili9341_font_t const ili9341_font_7x10;
 extern ili9341_font_t const ili9341_font_11x18;
 extern ili9341_font_t const ili9341_font_16x26;
 
+extern ili9341_aa_font_t const ili9341_font_aa_22x36;
+
 // ------------------------------------------------------- exported functions --
 
 uint8_t glyph_index(unsigned char glyph);
@@ -21,7 +21,9 @@ extern "C" {
 
 // ------------------------------------------------------------------ defines --
 
-/* nothing */
+#define __ILI9341_RAM2__ __attribute__((section(".ram2"))) // see the linker script
+
+#define __ILI9341_AA_STRING_MAX__ 8U // characters of an anti-aliased string
 
 // ------------------------------------------------------------------- macros --
 
@@ -36,6 +38,10 @@ extern "C" {
 #define __ILI9341_RGB(r,g,b) \
     (ili9341_color_rgb_t){ .red = (r), .green = (g), .blue = (b) }
 
+// 16-bit words of pixel data needed to cache n glyphs of a font
+#define __ILI9341_GLYPH_CACHE_WORDS(width, height, n) \
+    ((uint32_t)(width) * (uint32_t)(height) * (uint32_t)(n))
+
 // ----------------------------------------------------------- exported types --
 
 typedef uint16_t ili9341_color_t;
@@ -69,6 +75,19 @@ typedef struct
 }
 ili9341_text_attr_t;
 
+// glyphs of a font rendered ahead into RGB565 in a single color pair, so that
+// drawing one of the cached characters is a plain DMA transfer. meant for the
+// few characters drawn over and over again, like the digits of a readout.
+typedef struct
+{
+  ili9341_font_t const *font;
+  ili9341_color_t fg_color;
+  ili9341_color_t bg_color;
+  char const *chars;  // the cached characters, in the order of their glyphs
+  uint16_t   *pixels; // width * height words per glyph, native RGB565
+}
+ili9341_glyph_cache_t;
+
 // ------------------------------------------------------- exported variables --
 
 extern ili9341_color_t const ILI9341_BLACK;
@@ -100,8 +119,11 @@ void ili9341_spi_tft_set_address_rect(ili9341_t *lcd,
     uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1);
 
 void ili9341_transmit_wait(ili9341_t *lcd);
-void ili9341_transmit_color(ili9341_t *lcd, uint16_t size,
-    uint16_t color[]/* already byte-swapped (LE) */, ili9341_bool_t wait);
+void ili9341_transmit_color(ili9341_t *lcd, uint16_t count/* 16-bit words */,
+    uint16_t color[]/* native RGB565 */, ili9341_bool_t wait);
+void ili9341_transmit_fill(ili9341_t *lcd, uint32_t count/* 16-bit words */,
+    uint16_t color/* native RGB565 */, ili9341_bool_t wait);
+void ili9341_transmit_complete(ili9341_t *lcd);
 
 void ili9341_draw_pixel(ili9341_t *lcd, ili9341_color_t color,
     int16_t x, int16_t y);
@@ -125,9 +147,20 @@ void ili9341_draw_bitmap_1b(ili9341_t *lcd,
     ili9341_color_t fg_color, ili9341_color_t bg_color,
     int16_t x, int16_t y, uint16_t w, uint16_t h, uint8_t *bmp);
 
+ili9341_bool_t ili9341_glyph_cache_init(ili9341_glyph_cache_t *cache,
+    ili9341_font_t const *font, ili9341_color_t fg_color, ili9341_color_t bg_color,
+    char const chars[], uint16_t pixels[], uint32_t pixels_sz/* 16-bit words */);
+void ili9341_set_glyph_cache(ili9341_glyph_cache_t const *cache);
+
 void ili9341_draw_char(ili9341_t *lcd, ili9341_text_attr_t attr, char ch);
 void ili9341_draw_string(ili9341_t *lcd, ili9341_text_attr_t attr, char str[]);
 
+// a single line of anti-aliased text, decoded from flash as it is sent. it is
+// not clipped, nothing is drawn unless the whole line fits on the screen.
+void ili9341_draw_aa_string(ili9341_t *lcd, ili9341_aa_font_t const *font,
+    ili9341_color_t fg_color, ili9341_color_t bg_color,
+    int16_t x, int16_t y, char const str[]);
+
 #ifdef __cplusplus
 }
 #endif
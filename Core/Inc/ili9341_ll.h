@@ -0,0 +1,63 @@
+/*
+ * ili9341_ll.h
+ *
+ * Register level SPI access to the ILI9341, for the short command and
+ * parameter transfers where the overhead of the HAL exceeds the transfer
+ * itself. The bulk pixel data still goes through the HAL (DMA).
+ */
+
+#ifndef __ILI9341_LL_H
+#define __ILI9341_LL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// ----------------------------------------------------------------- includes --
+
+#include "ili9341.h"
+
+// ------------------------------------------------------------------ defines --
+
+#define __ILI9341_CMD_SWRESET__ 0x01
+#define __ILI9341_CMD_CASET__   0x2A
+#define __ILI9341_CMD_PASET__   0x2B
+#define __ILI9341_CMD_RAMWR__   0x2C
+#define __ILI9341_CMD_VSCRDEF__ 0x33
+#define __ILI9341_CMD_MADCTL__  0x36
+#define __ILI9341_CMD_VSCRSADD__ 0x37
+
+// ------------------------------------------------------- exported functions --
+
+// all of these expect the TFT to be selected, and return with the SPI
+// peripheral idle, so CS and D/C may be changed right after them.
+
+void ili9341_ll_write_command(ili9341_t *lcd, uint8_t command);
+void ili9341_ll_write_data(ili9341_t *lcd, uint16_t data_sz, uint8_t const data[]);
+void ili9341_ll_write_command_data(ili9341_t *lcd,
+    uint8_t command, uint16_t data_sz, uint8_t const data[]);
+
+void ili9341_ll_set_window(ili9341_t *lcd,
+    uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1);
+void ili9341_ll_invalidate_window(ili9341_t *lcd);
+
+// commands and parameters go out as 8-bit frames, the pixel data of RAMWR as
+// 16-bit frames, MSB first, straight from native RGB565 words. the frame size
+// is only changed (waiting for the SPI to go idle) when it differs.
+void ili9341_ll_set_frame_size(ili9341_t *lcd, uint32_t data_size);
+
+// the TX DMA moves 16-bit words. it streams a buffer with the memory
+// increment, or repeats a single word without it.
+void ili9341_ll_set_dma_source(ili9341_t *lcd, ili9341_bool_t increment);
+
+// the bus back-end (ili9341_ll_spi.c on the target, a model of the bus on the
+// host) implements the frame size, the DMA source and this one: sets D/C to
+// the given level and sends the bytes as 8-bit frames.
+void ili9341_ll_transmit(ili9341_t *lcd,
+    GPIO_PinState data_command, uint16_t data_sz, uint8_t const data[]);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __ILI9341_LL_H */
@@ -58,9 +58,14 @@ void Error_Handler(void);
 
 void handle_button_press();
 
+void handle_lead_off_change();
+
 /* USER CODE END EFP */
 
 /* Private defines -----------------------------------------------------------*/
+#define ADC_OS_RATIO ADC_OVERSAMPLING_RATIO_16
+#define ADC_OS_SHIFT ADC_RIGHTBITSHIFT_2
+#define ADC_DECIMATION 4
 #define BUTTON_Pin GPIO_PIN_0
 #define BUTTON_GPIO_Port GPIOA
 #define BUTTON_EXTI_IRQn EXTI0_IRQn
@@ -105,6 +110,20 @@ void handle_button_press();
 
 /* USER CODE BEGIN Private defines */
 
+// Number of leads acquired. The first lead is FE_OUT, the second one PA6 (ADC1_IN11), a third lead needs its
+// channel and pin to be defined for the board.
+#ifndef LEAD_COUNT
+#define LEAD_COUNT 1
+#endif
+
+#define LEAD2_ADC_CHANNEL ADC_CHANNEL_11
+#define LEAD2_Pin GPIO_PIN_6
+#define LEAD2_GPIO_Port GPIOA
+
+#if LEAD_COUNT > 2 && !defined(LEAD3_ADC_CHANNEL)
+#error "LEAD_COUNT > 2 needs LEAD3_ADC_CHANNEL, LEAD3_Pin and LEAD3_GPIO_Port"
+#endif
+
 #define TFT_CS_Pin GPIO_PIN_0
 #define TFT_CS_GPIO_Port GPIOB
 #define SPI1_TFT_SCK_Pin GPIO_PIN_1
@@ -0,0 +1,45 @@
+
+#ifndef MAINS_CANCELLER_H_
+#define MAINS_CANCELLER_H_
+
+#include "stm32l4xx_hal.h"
+#include <stdbool.h>
+
+#define MAINS_FREQUENCY_COUNT 2 // 50 and 60 Hz.
+
+#define MAINS_PHASE_PERIOD 20 // Common period of the references, in samples: 4 at 50 Hz and 10 at 60 Hz.
+
+// State of the adaptive mains interference canceller of a lead.
+typedef struct {
+  uint8_t frequency;     // Detected mains frequency, 50 or 60 Hz, 0 while it is being detected.
+  uint8_t phase;         // Sample counter of the reference sinusoids, modulo the period of both frequencies.
+  int32_t weight_sin;    // Weights of the reference sinusoids: the estimated interference, ADC counts in Q16.
+  int32_t weight_cos;
+  int32_t gradient_sin;  // Smoothed correlation of the output with the references, ADC counts in Q8.
+  int32_t gradient_cos;
+  uint16_t history[MAINS_PHASE_PERIOD]; // The input over the last common period, its average is the baseline.
+  uint32_t history_sum;
+  bool cancelling;       // The estimate is subtracted from the input, the interference is large enough to matter.
+
+  // The detection correlates the input with both frequencies over a window of whole periods.
+  uint16_t detection_count;
+  int64_t detection_sin[MAINS_FREQUENCY_COUNT];
+  int64_t detection_cos[MAINS_FREQUENCY_COUNT];
+} pt_mains_canceller_t;
+
+// Metrics of the canceller, for diagnostics.
+typedef struct {
+  uint8_t frequency;    // Detected mains frequency, 0 while it is being detected.
+  float amplitude;      // Amplitude of the interference being cancelled, ADC counts.
+  float residual_power; // Power of the interference left in the output, ADC counts squared.
+  bool converged;       // The residual is small compared to the cancelled interference.
+  bool cancelling;      // The interference is subtracted from the signal, not just tracked.
+} pt_mains_metrics_t;
+
+void reset_mains_canceller(pt_mains_canceller_t* canceller);
+
+uint16_t cancel_mains(pt_mains_canceller_t* canceller, uint16_t sample, bool adapt);
+
+void get_mains_metrics(const pt_mains_canceller_t* canceller, pt_mains_metrics_t* metrics);
+
+#endif /* MAINS_CANCELLER_H_ */
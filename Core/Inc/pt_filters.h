@@ -0,0 +1,24 @@
+
+#ifndef PT_FILTERS_H_
+#define PT_FILTERS_H_
+
+#include "stm32l4xx_hal.h"
+#include "signal_processing.h"
+
+#define PT_DCBLOCK_LIMIT 8191 // The DC blocked signal is clamped to +-PT_DCBLOCK_LIMIT, an artefact doesn't wrap it
+                              // around, and the samples of the beat template keep well within their 16 bits.
+
+// The buffers of one lane of the band-pass filter: the input, the DC blocked, the low pass and the high pass filtered
+// signal. All of them are rings of BUFFER_SIZE samples, indexed like the buffers of the detector.
+typedef struct {
+  const uint16_t* signal;
+  int16_t* dcblock;
+  int32_t* lowpass;
+  int32_t* highpass;
+} pt_filter_lane_t;
+
+// Filters the sample at array_index, given that the earlier samples are filtered already. restart restarts the DC
+// block from the sample, it has to be set for the first sample of a signal.
+void pt_filter(const pt_filter_lane_t* lane, uint32_t array_index, bool restart);
+
+#endif /* PT_FILTERS_H_ */
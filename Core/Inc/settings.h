@@ -0,0 +1,14 @@
+#ifndef INC_SETTINGS_H_
+#define INC_SETTINGS_H_
+
+#include "stm32l4xx_hal.h"
+#include <stdbool.h>
+#include "signal_processing.h"
+
+void settings_init(CRC_HandleTypeDef* crc);
+
+bool settings_load_detector_state(pt_state_t* state);
+
+bool settings_save_detector_state(const pt_state_t* state);
+
+#endif /* INC_SETTINGS_H_ */
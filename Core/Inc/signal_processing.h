@@ -3,12 +3,24 @@
 #define SIGNAL_PROCESSING_H_
 
 #include "stm32l4xx_hal.h"
+#include "mains_canceller.h"
+#include "beat_queue.h"
+#include "beat_template.h"
 
 #define SAMPLING_FREQUENCY 200          // Sampling frequency.
 
+#define ADC_SAMPLE_BITS 14              // Resolution of the samples: 12 bit conversions oversampled 16 times and shifted
+                                        // right by 2 bits, see ADC_OS_RATIO and ADC_OS_SHIFT in main.h.
+
+#define ADC_MAX_VALUE ((1 << ADC_SAMPLE_BITS) - 1)
+
+#define ADC_SATURATION_MARGIN (ADC_MAX_VALUE / 256) // Samples this close to 0 or ADC_MAX_VALUE are saturated.
+
 #define BUFFER_SIZE 500l // The size of the buffers (in samples). Must fit more than 1.66 times an RR interval, which
                          // typically could be around 1 second.
 
+#define MAX_RR_AVERAGE_INDEX 7 // The RR averages are taken over MAX_RR_AVERAGE_INDEX + 1 intervals.
+
 // Structure of the result of Pan-Tompkins algorithm.
 typedef struct {
   float peaki;
@@ -20,8 +32,165 @@ typedef struct {
   uint16_t rr_average2;
   bool is_regular;
   uint8_t evaluation;
+  bool is_restoring;    // The filters are recovering from a saturated input, no peaks are detected.
+  uint32_t r_peak_q8;      // Sample index of the R peak of the last detected beat, in 1/256 samples. Wraps around
+                           // after 23 hours, differences are still valid.
+  uint32_t rr_interval_us; // Time from the previous R peak to r_peak_q8 in microseconds, 0 if there was no previous
+                           // peak (first beat, or the first one after an interruption).
+  int16_t r_amplitude;     // Amplitude of that R peak in the DC blocked signal, ADC counts.
+  pt_detection_path_t detection_path; // How the last beat was found.
+  int16_t template_score;  // Correlation of the last beat with the template of the dominant beat, Q15.
+  pt_morphology_t morphology; // Shape of the last beat, from the template score.
 } pt_result_t;
 
-void process_pan_tompkins(uint16_t* signal, float* filtered, uint32_t current_index, pt_result_t* result);
+// Tunable parameters of the detector. The defaults reproduce the constants of the original implementation,
+// the host autotuner in Tools/pt_autotune searches over them.
+typedef struct {
+  float peak_weight;             // Weight of a new peak in the running signal/noise peak estimates (0.125).
+  float threshold_fraction;      // Position of threshold 1 between the noise and the signal peak estimate (0.25).
+  uint16_t window_size;          // Integrator window size, in samples (30).
+  float rr_low_limit;            // Shortest normal RR interval, relative to the normal RR average (0.92).
+  float rr_high_limit;           // Longest normal RR interval, relative to the normal RR average (1.16).
+  float rr_miss_limit;           // RR interval after which a beat is considered missed (1.66). Inert, only the
+                                 // back search reads it (as rrmiss), and the back search is disabled.
+  uint16_t rr_intervals_to_skip; // Number of beats ignored before the RR averages are seeded (0).
+  uint16_t learning_samples;     // Length of the threshold learning phase, in samples (400).
+} pt_params_t;
+
+// Adapted state of the detector, kept across power cycles so that a new measurement starts converged.
+// The thresholds are derived from the peak estimates, so they are not part of it.
+typedef struct {
+  float signalpeak_i;   // Signal peak estimate of the integrator.
+  float noisepeak_i;    // Noise peak estimate of the integrator.
+  float signalpeak_f;   // Signal peak estimate of the filtered signal.
+  float noisepeak_f;    // Noise peak estimate of the filtered signal.
+  uint16_t rr_average;  // Average of the recent RR intervals, in samples.
+  uint16_t rr_average2; // Average of the recent normal RR intervals, in samples.
+} pt_state_t;
+
+// State of one detector, there is one for each lead. The sample buffers come first, so the buffers of a lead are
+// contiguous and the filters of the leads run back-to-back over them.
+typedef struct {
+  // The outputs of each filtering module: mains canceller, DC Block, low pass, high pass, integral etc. The band-pass
+  // filter (DC block, low pass and high pass) works on integers, see pt_filters.c.
+  uint16_t cancelled[BUFFER_SIZE];
+  int16_t dcblock[BUFFER_SIZE];
+  int32_t lowpass[BUFFER_SIZE];
+  int32_t highpass[BUFFER_SIZE];
+  float derivative[BUFFER_SIZE];
+  float squared_derivative[BUFFER_SIZE];
+  float integral[BUFFER_SIZE];
+
+  // sample counts how many samples have been read so far.
+  // lastQRS stores which was the last sample read when the last R sample was triggered.
+  // lastSlope stores the value of the squared slope when the last R sample was triggered.
+  // currentSlope helps calculate the max. square slope for the present sample.
+  int32_t sample;
+  int32_t lastQRS;
+  float lastSlope;
+  float currentSlope;
+
+  // last_r_peak_q8 is the refined position of the last R peak, in 1/256 samples, valid if has_r_peak is set.
+  uint32_t last_r_peak_q8;
+  bool has_r_peak;
+
+  // The R peak of the current beat candidate, the QRS complex around it, and how it matches the template of the
+  // dominant beat. The template is kept across a restart, it is the same heart.
+  uint32_t candidate_r_peak_q8;
+  int16_t candidate_amplitude;
+  int16_t candidate_segment[TEMPLATE_SEGMENT_LENGTH];
+  pt_template_match_t candidate_match;
+  pt_beat_template_t beat_template;
+
+  // rejected_until is the last sample of the blanking after a candidate rejected as noise.
+  int32_t rejected_until;
+
+  // rr1 holds the last MAX_RR_AVERAGE_INDEX + 1 RR intervals. rr2 holds the last MAX_RR_AVERAGE_INDEX + 1 RR
+  // intervals between rrlow and rrhigh. rravg1 is the rr1 average, rravg2 is the rr2 average.
+  // rrlow is the lowest RR-interval considered normal for the current heart beat, while rrhigh is the highest.
+  // rrmiss is the longest that it would be expected until a new QRS is detected.
+  uint16_t rr1[MAX_RR_AVERAGE_INDEX + 1];
+  uint16_t rr2[MAX_RR_AVERAGE_INDEX + 1];
+  uint16_t rravg1;
+  uint16_t rravg2;
+  uint16_t rrlow;
+  uint16_t rrhigh;
+  uint16_t rrmiss;
+  uint16_t rr_count;
+  uint16_t last_rr_average_index;
+
+  // The variables from the original Pan-Tompkins algorithm. The ones ending in _i correspond to values from the
+  // integrator, the ones ending in _f to values from the DC-block/low-pass/high-pass filtered signal.
+  // The peak variables are peak candidates, the threshold 1 variables are the thresholds of a peak, the threshold 2
+  // variables are half of them, for the back search. The signalpeak and noisepeak variables are running estimates
+  // of signal and noise peaks.
+  float peak_i;
+  float peak_f;
+  float threshold_i1;
+  float threshold_i2;
+  float threshold_f1;
+  float threshold_f2;
+  float signalpeak_i;
+  float signalpeak_f;
+  float noisepeak_i;
+  float noisepeak_f;
+
+  // Learning phase 1 collects the maxima and the averages of the integrator and of the filtered signal, to seed the
+  // signal and noise peak estimates. Learning phase 2 seeds the RR averages from the first RR interval.
+  // thresholds_known tells that the peak estimates are already known, from a previous session or from before the
+  // signal was interrupted, so learning phase 1 only has to wait for the filters to settle.
+  uint32_t learning_count;
+  float learning_max_i;
+  float learning_max_f;
+  float learning_sum_i;
+  float learning_sum_f;
+  bool rr_seeded;
+  bool thresholds_known;
+
+  // restore_count counts down the samples of the fast restore after a saturated input, saturated tells whether the
+  // previous sample was saturated.
+  uint16_t restore_count;
+  bool saturated;
+
+  // The adaptive mains interference canceller in front of the filters.
+  pt_mains_canceller_t mains;
+
+  // regular tells whether the heart pace is regular, prevRegular whether it was before the newest RR-interval.
+  bool regular;
+  bool prevRegular;
+} pt_detector_t;
+
+#define MAX_LEAD_COUNT 8 // The leads voting for a beat are kept in a bit mask.
+
+// State of the fusion of the beats detected on the leads.
+typedef struct {
+  uint32_t candidate_index; // Sample index of the first detection of the open beat candidate.
+  uint8_t votes;            // Bit mask of the leads that detected the open candidate, 0 if there is none.
+  uint8_t first_lead;       // The lead that detected the open candidate first.
+  bool emitted;             // The open candidate got enough votes and was reported as a beat.
+  bool has_beat;            // A beat was reported already.
+  uint32_t last_beat_index; // Sample index of the last reported beat.
+  pt_beat_queue_t* queue;   // The reported beats are pushed here, if not NULL.
+} pt_fusion_t;
+
+extern const pt_params_t PT_DEFAULT_PARAMS;
+
+void set_pan_tompkins_params(const pt_params_t* params);
+
+void reset_pan_tompkins(pt_detector_t* detector);
+
+void restart_pan_tompkins(pt_detector_t* detector);
+
+bool get_pan_tompkins_state(const pt_detector_t* detector, pt_state_t* state);
+
+bool restore_pan_tompkins_state(pt_detector_t* detector, const pt_state_t* state);
+
+void process_pan_tompkins(pt_detector_t* detector, uint16_t* signal, float* filtered, uint32_t current_index,
+    pt_result_t* result);
+
+void reset_beat_fusion(pt_fusion_t* fusion, pt_beat_queue_t* queue);
+
+void fuse_beats(pt_fusion_t* fusion, const pt_result_t* results, uint8_t lead_count, uint32_t current_index,
+    pt_result_t* fused);
 
 #endif /* SIGNAL_PROCESSING_H_ */
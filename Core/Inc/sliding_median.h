@@ -0,0 +1,24 @@
+
+#ifndef INC_SLIDING_MEDIAN_H_
+#define INC_SLIDING_MEDIAN_H_
+
+#include "stm32l4xx_hal.h"
+
+// Median of the last size samples, updated in O(log size) per sample. The storage is given by the caller, each of
+// the arrays has size elements. size must be odd and at most 255.
+typedef struct {
+  int16_t* data;  // The window, a ring buffer.
+  int16_t* pos;   // Position of each sample of the window in the heap, relative to its middle.
+  uint8_t* heap;  // A max-heap of the lower half at negative positions, the median at 0, a min-heap of the upper half
+                  // at positive positions. It holds indices into data.
+  uint8_t size;
+  uint8_t index;  // The oldest sample of the window, replaced by the next one.
+} sliding_median_t;
+
+void sliding_median_init(sliding_median_t* median, int16_t* data, int16_t* pos, uint8_t* heap, uint8_t size);
+
+void sliding_median_fill(sliding_median_t* median, int16_t value);
+
+int16_t sliding_median_insert(sliding_median_t* median, int16_t value);
+
+#endif /* INC_SLIDING_MEDIAN_H_ */
@@ -59,6 +59,7 @@ void EXTI0_IRQHandler(void);
 void DMA1_Channel1_IRQHandler(void);
 void DMA1_Channel3_IRQHandler(void);
 void TIM1_UP_TIM16_IRQHandler(void);
+void EXTI15_10_IRQHandler(void);
 void TIM7_IRQHandler(void);
 void LPTIM1_IRQHandler(void);
 /* USER CODE BEGIN EFP */
@@ -0,0 +1,46 @@
+#include "stm32l4xx_hal.h"
+#include <stdbool.h>
+#include <string.h>
+#include "beat_queue.h"
+
+/*
+    Bounded broadcast queue of the detected beats. The detector and the consumers all run in the main loop, so
+    there is no locking. The counters only grow, wrapping around together after 2^32 beats, so the number of unread
+    beats of a cursor is always pushed - read.
+*/
+
+#define SLOT(n) ((n) % BEAT_QUEUE_SIZE)
+
+void reset_beat_queue(pt_beat_queue_t* queue) {
+  memset(queue, 0, sizeof(pt_beat_queue_t));
+}
+
+void push_beat_event(pt_beat_queue_t* queue, const pt_beat_event_t* event) {
+  queue->events[SLOT(queue->pushed)] = *event;
+  queue->pushed++;
+}
+
+/*
+    Starts a consumer at the end of the queue, it will read the beats pushed from now on.
+*/
+void attach_beat_cursor(const pt_beat_queue_t* queue, pt_beat_cursor_t* cursor) {
+  cursor->read = queue->pushed;
+  cursor->dropped = 0;
+}
+
+/*
+    Copies the oldest beat the consumer hasn't read yet into event. Returns false if there is none.
+*/
+bool next_beat_event(const pt_beat_queue_t* queue, pt_beat_cursor_t* cursor, pt_beat_event_t* event) {
+  uint32_t unread = queue->pushed - cursor->read;
+  if (unread == 0) {
+    return false;
+  }
+  if (unread > BEAT_QUEUE_SIZE) {
+    cursor->dropped += unread - BEAT_QUEUE_SIZE;
+    cursor->read = queue->pushed - BEAT_QUEUE_SIZE;
+  }
+  *event = queue->events[SLOT(cursor->read)];
+  cursor->read++;
+  return true;
+}
@@ -0,0 +1,134 @@
+#include "stm32l4xx_hal.h"
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+#include "beat_template.h"
+#include "dsp_simd.h"
+
+/*
+    Morphology of the beats. The dominant beat of a lead is kept as an ensemble average of the QRS complexes that
+    matched it, and every new beat is compared to it with the normalized cross-correlation (Pearson correlation):
+      r = (N sum(xy) - sum(x) sum(y)) / sqrt((N sum(x^2) - sum(x)^2) (N sum(y^2) - sum(y)^2))
+    It doesn't depend on the amplitude or the baseline of the beat, only on its shape.
+    The sums over a window are taken two samples at a time with the dual 16 bit multiply-accumulate (SMLAD). The
+    sums of the template are kept with it, so a window costs TEMPLATE_LENGTH / 2 SMLADs for sum(xy), as many for
+    sum(x^2) and for sum(x), and one division. The beat is matched at 2 * TEMPLATE_MAX_SHIFT + 1 alignments, about a
+    thousand cycles per beat with the update of the template.
+*/
+
+#define TEMPLATE_AVERAGE_SHIFT 3 // A matching beat moves the template by 1/8 of the difference.
+
+#define TEMPLATE_MIN_BEATS 4     // The template is used for the classification from this many averaged beats.
+
+#define TEMPLATE_RESEED_BEATS 8  // After this many consecutive mismatching beats or rejected candidates the template
+                                 // starts again from the next beat, the dominant beat has changed (or the template
+                                 // was seeded on noise).
+
+#define ONES 0x00010001 // A pair of 1s, SMLAD with it adds the lanes of the other operand.
+
+// Reads two consecutive 16 bit samples as one word, the first one in lane 0. The address may be unaligned.
+static inline uint32_t read_pair(const int16_t* address) {
+  uint32_t value;
+  memcpy(&value, address, sizeof(value));
+  return value;
+}
+
+static void seed_template(pt_beat_template_t* beat_template, const int16_t* window) {
+  for (uint8_t i = 0; i < TEMPLATE_LENGTH; i++) {
+    beat_template->sum[i] = (int32_t) window[i] << TEMPLATE_AVERAGE_SHIFT;
+  }
+  beat_template->beat_count = 0;
+}
+
+// Moves the template toward the window, and updates the rounded samples and their sums.
+static void average_template(pt_beat_template_t* beat_template, const int16_t* window) {
+  int32_t samples_sum = 0, samples_energy = 0;
+  for (uint8_t i = 0; i < TEMPLATE_LENGTH; i++) {
+    beat_template->sum[i] += window[i] - (beat_template->sum[i] >> TEMPLATE_AVERAGE_SHIFT);
+    int16_t sample = (beat_template->sum[i] + (1 << (TEMPLATE_AVERAGE_SHIFT - 1))) >> TEMPLATE_AVERAGE_SHIFT;
+    beat_template->samples[i] = sample;
+    samples_sum += sample;
+    samples_energy += sample * sample;
+  }
+  beat_template->samples_sum = samples_sum;
+  beat_template->samples_energy = samples_energy;
+  if (beat_template->beat_count < UINT16_MAX) {
+    beat_template->beat_count++;
+  }
+}
+
+void reset_beat_template(pt_beat_template_t* beat_template) {
+  memset(beat_template, 0, sizeof(pt_beat_template_t));
+}
+
+bool is_beat_template_ready(const pt_beat_template_t* beat_template) {
+  return beat_template->beat_count >= TEMPLATE_MIN_BEATS;
+}
+
+/*
+    Correlates the template with the segment of a beat (TEMPLATE_SEGMENT_LENGTH samples, the R peak in the middle of
+    the template window) at each alignment, and gives the best aligned one: the largest |r|, with its sign, so an
+    inverted beat is taken at its most negative score. Without a template the score is 0.
+*/
+void match_beat_template(const pt_beat_template_t* beat_template, const int16_t* segment, pt_template_match_t* match) {
+  match->score = 0;
+  match->shift = 0;
+  if (beat_template->beat_count == 0) {
+    return;
+  }
+
+  int64_t template_variance = (int64_t) TEMPLATE_LENGTH * beat_template->samples_energy -
+      (int64_t) beat_template->samples_sum * beat_template->samples_sum;
+  float best = 0;
+  for (int8_t shift = -TEMPLATE_MAX_SHIFT; shift <= TEMPLATE_MAX_SHIFT; shift++) {
+    const int16_t* window = segment + TEMPLATE_MAX_SHIFT + shift;
+    uint32_t cross = 0, energy = 0, sum = 0;
+    for (uint8_t i = 0; i < TEMPLATE_LENGTH; i += 2) {
+      uint32_t x = read_pair(&window[i]);
+      cross = __SMLAD(x, read_pair(&beat_template->samples[i]), cross);
+      energy = __SMLAD(x, x, energy);
+      sum = __SMLAD(x, ONES, sum);
+    }
+    int64_t covariance = (int64_t) TEMPLATE_LENGTH * (int32_t) cross - (int64_t) (int32_t) sum * beat_template->samples_sum;
+    int64_t variance = (int64_t) TEMPLATE_LENGTH * (int32_t) energy - (int64_t) (int32_t) sum * (int32_t) sum;
+    float score = variance > 0 && template_variance > 0 ?
+        (float) covariance / sqrtf((float) variance * (float) template_variance) : 0;
+    if (fabsf(score) > fabsf(best)) {
+      best = score;
+      match->shift = shift;
+    }
+  }
+  match->score = best * TEMPLATE_SCORE_ONE;
+}
+
+/*
+    Averages a matched beat into the template if it is a dominant beat, seeds the template from the first beat, and
+    starts it again from the beat after too many mismatching ones.
+*/
+void update_beat_template(pt_beat_template_t* beat_template, const int16_t* segment, const pt_template_match_t* match) {
+  const int16_t* window = segment + TEMPLATE_MAX_SHIFT + match->shift;
+  if (beat_template->beat_count == 0 || beat_template->mismatch_count >= TEMPLATE_RESEED_BEATS) {
+    seed_template(beat_template, window);
+    average_template(beat_template, window);
+    beat_template->mismatch_count = 0;
+  }
+  else if (match->score >= TEMPLATE_DOMINANT_SCORE) {
+    average_template(beat_template, window);
+    beat_template->mismatch_count = 0;
+  }
+  else {
+    beat_template->mismatch_count++;
+  }
+}
+
+/*
+    Counts a candidate rejected for not matching the template. A rejected candidate is never averaged into the
+    template, so if the dominant beat changes (a new rhythm, a moved electrode) every beat would be rejected for good.
+    After too many of them in a row the template is dropped: until it has formed again every candidate is taken for a
+    beat, and the next one seeds it.
+*/
+void reject_beat_template_candidate(pt_beat_template_t* beat_template) {
+  if (++beat_template->mismatch_count >= TEMPLATE_RESEED_BEATS) {
+    reset_beat_template(beat_template);
+  }
+}
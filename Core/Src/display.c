@@ -7,6 +7,8 @@
 #include "ad_header.h"
 #include "stm32l4xx_hal_dac.h"
 #include "signal_processing.h"
+#include "settings.h"
+#include "display_filter.h"
 
 #define VERSION "1.0"
 
@@ -16,9 +18,18 @@
 
 #define MAX_HEIGHT 239
 
+#define COLUMN_COUNT 320 // Width of the screen in landscape.
+
+#define SWEEP_GAP 8 // The sweep erases this many columns ahead of the trace, leaving a gap before the previous one.
+
+#define SAMPLE_SCALE (1 << (ADC_SAMPLE_BITS - 12)) // The signal related constants are given for 12 bit samples.
+
 #define MENU_ITEM_PAUSE 0
 #define MENU_ITEM_SOUND 1
-#define MENU_ITEM_BACK 2
+#define MENU_ITEM_FILTER 2
+#define MENU_ITEM_NOTCH 3
+#define MENU_ITEM_SCROLL 4
+#define MENU_ITEM_BACK 5
 
 #define RULER_TICK_Y1 225
 #define SEC_RULER_TICK_Y2 210
@@ -26,20 +37,32 @@
 #define SEC_MOD 800
 #define HALF_SEC_MOD 400
 
-#define FILTERED_DC_SHIFT(X) ((X / 200) + 2000)
+#define QRS_MARK_Y1 210
+#define QRS_MARK_Y2 230
+
+#define DISPLAY_BASELINE ((MIN_Y + MAX_Y) / 2) // The display filtered signal is around 0, it is drawn around this level.
 #
 #define GRAPH_Y1 50
 #define GRAPH_Y2 160
 
-#define MIN_Y 700
-#define MAX_Y 3000
+#define MIN_Y (700 * SAMPLE_SCALE)
+#define MAX_Y (3000 * SAMPLE_SCALE)
 
 #define PULSE_X 200
-#define PULSE_Y 12
+#define PULSE_Y 12 // The pulse is drawn with ili9341_font_aa_22x36, down to GRAPH_Y1.
 
 #define EVALUATION_X 60
 #define EVALUATION_Y 12
 
+#define LEAD_OFF_X 105
+#define LEAD_OFF_Y 110
+
+#define SCROLL_WIDTH 248 // In the scrolling mode the trace scrolls on the left, the texts stay on the right of it.
+
+#define INFO_X (SCROLL_WIDTH + 3) // Three digits of the pulse fit right of the trace.
+#define INFO_PULSE_Y 12
+#define INFO_EVALUATION_Y 56
+
 #define TEXT_COLOR ILI9341_LIGHTGREY
 #define TEXT_BACKGROUND ILI9341_BLACK
 #define HIGHLIGHTED_TEXT_COLOR ILI9341_DARKGREY
@@ -49,11 +72,23 @@
 #define FILTERED_SIGNAL_COLOR ILI9341_GREEN
 #define QRS_COLOR ILI9341_RED
 
-#define MENU_SIZE 3
+#define MENU_SIZE 6
 
 char* EVALUATION_TEXTS[] = {"Nor", "Arr"};
 
-char* MENU_TEXTS[] = {"Szunet", "Hang", "Vissza"};
+char* MENU_TEXTS[] = {"Szunet", "Hang", NULL, NULL, NULL, "Vissza"};
+
+// The texts of the menu items showing a setting have the same length, so they overwrite each other.
+char* FILTER_PROFILE_TEXTS[] = {"Monitor   ", "Diagnoszt."};
+
+char* NOTCH_TEXTS[] = {"Halozat ki", "Halozat 50", "Halozat 60"};
+
+char* SCROLL_TEXTS[] = {"Sopres    ", "Gorgetes  "};
+
+char* LEAD_OFF_TEXTS[] = {"          ", "Elektroda?"};
+
+// The characters of the evaluation texts. They are drawn from glyphs rendered once into SRAM2.
+#define READOUT_GLYPHS "NorA"
 
 typedef enum {
   MEASURE = 0,
@@ -70,23 +105,76 @@ TIM_HandleTypeDef* timer_hal;
 
 ili9341_t* ili9341_lcd;
 
-uint16_t dma_values[0];
+ili9341_glyph_cache_t readout_glyphs;
+
+uint16_t readout_glyph_pixels[__ILI9341_GLYPH_CACHE_WORDS(11, 18, sizeof(READOUT_GLYPHS) - 1)] __ILI9341_RAM2__; // ili9341_font_11x18
 
-uint16_t raw_values[BUFFER_SIZE] = {0};
+// The oversampled conversions of the last sampling period, averaged by the sampling timer. The conversions of the
+// leads are interleaved.
+uint16_t dma_values[ADC_DECIMATION * LEAD_COUNT];
+
+uint16_t raw_values[LEAD_COUNT][BUFFER_SIZE] = {0};
 
 uint32_t time_buffer[BUFFER_SIZE] = {0};
 
-float filtered[BUFFER_SIZE] = {0};
+float filtered[LEAD_COUNT][BUFFER_SIZE] = {0};
+
+// The first lead through the display filter, this is the trace on the screen.
+int16_t display_values[BUFFER_SIZE] = {0};
+
+// The R peaks by sample index, they are drawn together with the delayed trace.
+bool qrs_marks[BUFFER_SIZE] = {0};
+
+display_filter_profile_t filter_profile = DISPLAY_FILTER_MONITOR;
+
+display_filter_notch_t filter_notch = DISPLAY_NOTCH_OFF;
+
+// The filter settings are changed from the button interrupt, filter_changed tells the main loop to apply them.
+bool filter_changed = false;
+
+// The trace either sweeps over the screen, or scrolls in the hardware, see select_layout(). The button interrupt
+// only asks for the change with scroll_toggled, the main loop makes it.
+bool scroll_mode = false, scroll_toggled = false;
+
+// While the trace stops in the scrolling mode the strip holds still, see hold_scroll().
+bool scroll_held = false;
+
+// The rows drawn on in each column of the trace, and whether the ruler or a QRS mark was drawn in it, so that
+// erase_column() only clears those instead of the whole column. An empty span has top > bottom.
+uint8_t drawn_top[COLUMN_COUNT], drawn_bottom[COLUMN_COUNT];
+
+bool drawn_marks[COLUMN_COUNT];
+
+// The mode the screen was last drawn in, the trace erases the whole screen once after the menu.
+T_Mode drawn_mode = MEASURE;
 
 uint32_t fill_index = 0;
 
 uint32_t current_index = 0;
 
+// One detector for each lead, their beats are fused into result.
+pt_detector_t detectors[LEAD_COUNT];
+
+pt_result_t lead_results[LEAD_COUNT];
+
+pt_fusion_t fusion;
+
 pt_result_t result;
 
+// The fused beats. The QRS marks are taken from it on every sample, the pulse text once per screen update.
+pt_beat_queue_t beats;
+
+pt_beat_cursor_t mark_cursor, pulse_cursor;
+
 uint8_t lcd_brightness = 130;
 
-bool active = false, enabled = true, paused = false, initialized = false;
+bool active = false, enabled = true, paused = false, initialized = false, lcd_ready = false;
+
+// leads_off is set from the lead-off interrupt, lead_off_handled is the state the main loop last acted on.
+bool leads_off = false, lead_off_handled = false;
+
+// Set from the shutdown timer interrupt, the main loop saves the detector state and switches the power off.
+bool shutdown_requested = false;
 
 T_Mode mode = MEASURE;
 
@@ -96,7 +184,7 @@ int16_t rotary_position = 0;
 
 const uint8_t MIN_BRIGHTNESS = 80, MAX_BRIGHTNESS = 250, BRIGHTNESS_STEP = 10;
 
-ili9341_text_attr_t MENU_TEXT_ATTR, PULSE_TEXT_ATTR, EVALUATION_ATTR;
+ili9341_text_attr_t MENU_TEXT_ATTR, PULSE_TEXT_ATTR, EVALUATION_ATTR, LEAD_OFF_ATTR;
 
 void init_display(SPI_HandleTypeDef* spi,
     TIM_HandleTypeDef* timer,
@@ -116,19 +204,6 @@ void init_display(SPI_HandleTypeDef* spi,
           TOUCH_IRQ_GPIO_Port, TOUCH_IRQ_Pin,
           itsSupported,
           itnNormalized);
-  ili9341_spi_tft_select(ili9341_lcd);
-  ili9341_fill_screen(ili9341_lcd, TEXT_BACKGROUND);
-  ili9341_text_attr_t attr;
-  attr.bg_color = TEXT_BACKGROUND;
-  attr.fg_color = TEXT_COLOR;
-  attr.font = &ili9341_font_16x26;
-  attr.origin_x = 60;
-  attr.origin_y = 100;
-  ili9341_draw_string(ili9341_lcd, attr, "EKG MONITOR");
-  attr.font = &ili9341_font_11x18;
-  attr.origin_x = 120;
-  attr.origin_y = 150;
-  ili9341_draw_string(ili9341_lcd, attr, VERSION);
 
   MENU_TEXT_ATTR.fg_color = TEXT_COLOR;
   MENU_TEXT_ATTR.font = &ili9341_font_11x18;
@@ -145,25 +220,231 @@ void init_display(SPI_HandleTypeDef* spi,
   EVALUATION_ATTR.origin_x = EVALUATION_X;
   EVALUATION_ATTR.origin_y = EVALUATION_Y;
 
+  LEAD_OFF_ATTR.bg_color = TEXT_BACKGROUND;
+  LEAD_OFF_ATTR.fg_color = QRS_COLOR;
+  LEAD_OFF_ATTR.font = &ili9341_font_11x18;
+  LEAD_OFF_ATTR.origin_x = LEAD_OFF_X;
+  LEAD_OFF_ATTR.origin_y = LEAD_OFF_Y;
+
+  if (ili9341_glyph_cache_init(&readout_glyphs, &ili9341_font_11x18, TEXT_COLOR, TEXT_BACKGROUND, READOUT_GLYPHS,
+      readout_glyph_pixels, sizeof(readout_glyph_pixels) / sizeof(uint16_t))) {
+    ili9341_set_glyph_cache(&readout_glyphs);
+  }
+
+  for (uint8_t lead = 0; lead < LEAD_COUNT; lead++) {
+    reset_pan_tompkins(&detectors[lead]);
+  }
+  reset_beat_queue(&beats);
+  attach_beat_cursor(&beats, &mark_cursor);
+  attach_beat_cursor(&beats, &pulse_cursor);
+  reset_beat_fusion(&fusion, &beats);
+  display_filter_select(filter_profile, filter_notch);
+
+  pt_state_t detector_state;
+  if (settings_load_detector_state(&detector_state)) {
+    restore_pan_tompkins_state(&detectors[0], &detector_state);
+  }
+
   enableAD();
 
-  HAL_ADC_Start_DMA(adc, (uint32_t*) dma_values, 1);
+  HAL_ADC_Start_DMA(adc, (uint32_t*) dma_values, ADC_DECIMATION * LEAD_COUNT);
 
   initialized = true;
 }
 
+/*
+    Resets what is known to be drawn in the columns: all of them (whole) after something else was drawn over the
+    trace, or none of them after the screen was cleared.
+*/
+void reset_columns(bool whole) {
+  memset(drawn_top, whole ? 0 : UINT8_MAX, sizeof(drawn_top));
+  memset(drawn_bottom, whole ? MAX_HEIGHT : 0, sizeof(drawn_bottom));
+  memset(drawn_marks, whole, sizeof(drawn_marks));
+}
+
+void mark_column(uint16_t x, uint16_t y1, uint16_t y2) {
+  uint16_t top = y1 < y2 ? y1 : y2, bottom = y1 < y2 ? y2 : y1;
+  if (top < drawn_top[x]) {
+    drawn_top[x] = top;
+  }
+  if (bottom > drawn_bottom[x]) {
+    drawn_bottom[x] = bottom;
+  }
+}
+
+/*
+    Erases what was drawn in the column, usually a span of some pixels of the trace instead of the whole height.
+*/
+void erase_column(uint16_t x) {
+  if (drawn_top[x] <= drawn_bottom[x]) {
+    ili9341_fill_rect(ili9341_lcd, TEXT_BACKGROUND, x, drawn_top[x], 1, drawn_bottom[x] - drawn_top[x] + 1);
+    drawn_top[x] = UINT8_MAX;
+    drawn_bottom[x] = 0;
+  }
+  if (drawn_marks[x]) {
+    ili9341_fill_rect(ili9341_lcd, TEXT_BACKGROUND, x, QRS_MARK_Y1, 1, QRS_MARK_Y2 - QRS_MARK_Y1);
+    drawn_marks[x] = false;
+  }
+}
+
+/*
+    Draws the start screen, once the LCD finished its reset sequence.
+*/
+void draw_splash() {
+  ili9341_spi_tft_select(ili9341_lcd);
+  ili9341_fill_screen(ili9341_lcd, TEXT_BACKGROUND);
+  ili9341_text_attr_t attr;
+  attr.bg_color = TEXT_BACKGROUND;
+  attr.fg_color = TEXT_COLOR;
+  attr.font = &ili9341_font_16x26;
+  attr.origin_x = 60;
+  attr.origin_y = 100;
+  ili9341_draw_string(ili9341_lcd, attr, "EKG MONITOR");
+  attr.font = &ili9341_font_11x18;
+  attr.origin_x = 120;
+  attr.origin_y = 150;
+  ili9341_draw_string(ili9341_lcd, attr, VERSION);
+  reset_columns(true);
+}
+
+/*
+    Sets up the screen for the sweeping or the scrolling trace. In the scrolling mode the panel scrolls the columns
+    of the trace in the hardware (VSCRDEF / VSCRSADD), each sample only writes its new column, and the pulse and
+    the evaluation are shown in the fixed area right of it.
+*/
+void select_layout() {
+  ili9341_fill_screen(ili9341_lcd, TEXT_BACKGROUND);
+  reset_columns(false);
+  scroll_held = false;
+  if (scroll_mode && ili9341_scroll_define(ili9341_lcd, 0, SCROLL_WIDTH)) {
+    PULSE_TEXT_ATTR.origin_x = INFO_X;
+    PULSE_TEXT_ATTR.origin_y = INFO_PULSE_Y;
+    EVALUATION_ATTR.origin_x = INFO_X;
+    EVALUATION_ATTR.origin_y = INFO_EVALUATION_Y;
+  }
+  else {
+    scroll_mode = false;
+    ili9341_scroll_stop(ili9341_lcd);
+    PULSE_TEXT_ATTR.origin_x = PULSE_X;
+    PULSE_TEXT_ATTR.origin_y = PULSE_Y;
+    EVALUATION_ATTR.origin_x = EVALUATION_X;
+    EVALUATION_ATTR.origin_y = EVALUATION_Y;
+  }
+  if (lead_off_handled) {
+    ili9341_draw_string(ili9341_lcd, LEAD_OFF_ATTR, LEAD_OFF_TEXTS[1]);
+  }
+}
+
+/*
+    In the scrolling mode the trace stops while the menu is open or the leads are off. The strip is rewound and
+    cleared then, so that the texts drawn on it show where they are drawn, and cleared again when the trace goes on.
+*/
+void hold_scroll(bool hold) {
+  if (!scroll_mode || hold == scroll_held) {
+    return;
+  }
+  ili9341_scroll_rewind(ili9341_lcd);
+  ili9341_fill_rect(ili9341_lcd, TEXT_BACKGROUND, 0, 0, SCROLL_WIDTH, ili9341_lcd->screen_size.height);
+  reset_columns(false);
+  scroll_held = hold;
+}
+
+/*
+    Acts on a change of the lead-off state. While the leads are off the acquired samples are dropped, as they are
+    only saturated noise, and a status text replaces the trace. When the leads are back the detector restarts its
+    filters. Returns true while the leads are off.
+*/
+bool handle_lead_off() {
+  bool off = leads_off;
+  if (off) {
+    current_index = fill_index;
+  }
+  if (off != lead_off_handled) {
+    if (!off) {
+      for (uint8_t lead = 0; lead < LEAD_COUNT; lead++) {
+        restart_pan_tompkins(&detectors[lead]);
+      }
+      display_filter_reset();
+    }
+    if (lcd_ready) {
+      hold_scroll(off || mode == MENU);
+      ili9341_draw_string(ili9341_lcd, LEAD_OFF_ATTR, LEAD_OFF_TEXTS[off]);
+    }
+    lead_off_handled = off;
+  }
+  return off;
+}
+
+/*
+    Runs the detectors of all leads on the sample at current_index and votes on their beats. The first lead is also
+    filtered for the display.
+*/
+void process_sample() {
+  if (filter_changed) {
+    filter_changed = false;
+    display_filter_select(filter_profile, filter_notch);
+  }
+  for (uint8_t lead = 0; lead < LEAD_COUNT; lead++) {
+    process_pan_tompkins(&detectors[lead], raw_values[lead], filtered[lead], current_index, &lead_results[lead]);
+  }
+  fuse_beats(&fusion, lead_results, LEAD_COUNT, current_index, &result);
+  // The R peak is a few tens of samples back, still ahead of the drawn part of the trace.
+  qrs_marks[MOD_INDEX(current_index)] = false;
+  pt_beat_event_t beat;
+  while (next_beat_event(&beats, &mark_cursor, &beat)) {
+    // r_peak_q8 wraps around after 2^24 samples, which isn't a multiple of BUFFER_SIZE, so the peak is placed back
+    // from the detection by the difference of the two.
+    uint32_t r_peak_index = beat.sample_index - (((beat.sample_index << 8) - beat.r_peak_q8 + 128) >> 8);
+    qrs_marks[MOD_INDEX(r_peak_index)] = true;
+  }
+  display_values[MOD_INDEX(current_index - DISPLAY_FILTER_DELAY)] = display_filter_process(raw_values[0][MOD_INDEX(current_index)]);
+}
+
 uint16_t translate_y(uint16_t value) {
   return GRAPH_Y1 + GRAPH_Y2 - 1 - (value - MIN_Y) * (float) GRAPH_Y2 / (MAX_Y - MIN_Y);
 }
 
-void print_result(pt_result_t *r) {
-  if (r->evaluation > 0) {
-    ili9341_draw_string(ili9341_lcd, EVALUATION_ATTR, EVALUATION_TEXTS[r->evaluation == 1? 0 : 1]);
+/*
+    Screen row of a display filtered sample, kept within the graph.
+*/
+uint16_t display_y(int16_t value) {
+  int32_t level = DISPLAY_BASELINE + value;
+  if (level < MIN_Y) {
+    level = MIN_Y;
+  }
+  else if (level > MAX_Y) {
+    level = MAX_Y;
   }
-  if (r->rr_average > 0) {
+  return translate_y(level);
+}
+
+void print_beat(const pt_beat_event_t* beat) {
+  // An irregular rhythm or a beat of a different shape than the dominant one.
+  if (beat->morphology == PT_MORPHOLOGY_ABERRANT) {
+    ili9341_draw_string(ili9341_lcd, EVALUATION_ATTR, EVALUATION_TEXTS[1]);
+  }
+  else if (beat->evaluation > 0) {
+    ili9341_draw_string(ili9341_lcd, EVALUATION_ATTR, EVALUATION_TEXTS[beat->evaluation == 1? 0 : 1]);
+  }
+  if (beat->rr_average > 0) {
     char text[6];
-    sprintf(text, "%-3d", RR_TO_PULSE((float) r->rr_average));
-    ili9341_draw_string(ili9341_lcd, PULSE_TEXT_ATTR, text);
+    sprintf(text, "%-3d", RR_TO_PULSE((float) beat->rr_average));
+    ili9341_draw_aa_string(ili9341_lcd, &ili9341_font_aa_22x36, PULSE_TEXT_ATTR.fg_color, PULSE_TEXT_ATTR.bg_color,
+        PULSE_TEXT_ATTR.origin_x, PULSE_TEXT_ATTR.origin_y, text);
+  }
+}
+
+/*
+    Shows the evaluation and the pulse of the latest beat, if there was a new one since the last call.
+*/
+void print_beats() {
+  pt_beat_event_t beat;
+  bool has_beat = false;
+  while (next_beat_event(&beats, &pulse_cursor, &beat)) {
+    has_beat = true;
+  }
+  if (has_beat) {
+    print_beat(&beat);
   }
 }
 
@@ -173,56 +454,151 @@ void draw_menu() {
     MENU_TEXT_ATTR.bg_color = menu.selected == i ? HIGHLIGHTED_TEXT_BACKGROUND : TEXT_BACKGROUND;
     MENU_TEXT_ATTR.origin_x = x;
     MENU_TEXT_ATTR.origin_y = y + i * 18;
-    ili9341_draw_string(ili9341_lcd, MENU_TEXT_ATTR, MENU_TEXTS[i]);
+    char* text = MENU_TEXTS[i];
+    if (i == MENU_ITEM_FILTER) {
+      text = FILTER_PROFILE_TEXTS[filter_profile];
+    }
+    else if (i == MENU_ITEM_NOTCH) {
+      text = NOTCH_TEXTS[filter_notch];
+    }
+    else if (i == MENU_ITEM_SCROLL) {
+      text = SCROLL_TEXTS[scroll_mode];
+    }
+    ili9341_draw_string(ili9341_lcd, MENU_TEXT_ATTR, text);
   }
 }
 
+/*
+    Draws the column of the sample at index: the ruler, the display filtered signal of the first lead and the QRS mark.
+    The column is the next one of the sweep, or in the scrolling mode the one scrolled in at the right edge. Only what
+    was drawn before is erased, the sweep erases it SWEEP_GAP columns ahead.
+*/
+void draw_sample(uint32_t index) {
+  uint16_t draw_index = MOD_INDEX(index);
+  uint16_t previous_draw_index = MOD_INDEX(draw_index - 1);
+  uint16_t width = ili9341_lcd->screen_size.width;
+  uint16_t x = scroll_mode ? ili9341_scroll_column(ili9341_lcd) : index % width;
+  if (!scroll_mode) {
+    erase_column((x + SWEEP_GAP) % width);
+  }
+  // Already erased ahead by the sweep, unless the trace just started.
+  erase_column(x);
+  // draw ruler
+  uint32_t current_time = time_buffer[draw_index];
+  if (current_time % SEC_MOD < 5) {
+    ili9341_draw_line(ili9341_lcd, ILI9341_DARKGREY, x, SEC_RULER_TICK_Y2, x, RULER_TICK_Y1);
+    drawn_marks[x] = true;
+  }
+  else if (current_time % HALF_SEC_MOD < 5) {
+    ili9341_draw_line(ili9341_lcd, ILI9341_DARKGREY, x, HALF_SEC_RULER_TICK_Y2, x, RULER_TICK_Y1);
+    drawn_marks[x] = true;
+  }
+
+  // draw raw signal
+//  if (x == 0) {
+//    ili9341_draw_pixel(ili9341_lcd, RAW_SIGNAL_COLOR, x, translate_y(raw_values[0][draw_index]));
+//  }
+//  else {
+//    ili9341_draw_line(ili9341_lcd, RAW_SIGNAL_COLOR, x - 1, translate_y(raw_values[0][previous_draw_index]), x, translate_y(raw_values[0][draw_index]));
+//  }
+
+  // draw the display filtered signal of the first lead
+  uint16_t y = display_y(display_values[draw_index]);
+  uint16_t previous_y = display_y(display_values[previous_draw_index]);
+  if (scroll_mode) {
+    // The previous column has scrolled on already, the step from the previous sample is drawn in this one.
+    uint16_t top = y < previous_y ? y : previous_y;
+    ili9341_fill_rect(ili9341_lcd, FILTERED_SIGNAL_COLOR, x, top, 1, (y < previous_y ? previous_y - y : y - previous_y) + 1);
+    mark_column(x, y, previous_y);
+  }
+  else if (x == 0) {
+    ili9341_draw_pixel(ili9341_lcd, FILTERED_SIGNAL_COLOR, x, y);
+    mark_column(x, y, y);
+  }
+  else {
+    // The line is split between the two columns, both keep all of its rows.
+    ili9341_draw_line(ili9341_lcd, FILTERED_SIGNAL_COLOR, x - 1, previous_y, x, y);
+    mark_column(x - 1, y, previous_y);
+    mark_column(x, y, previous_y);
+  }
+  if (qrs_marks[draw_index]) {
+    ili9341_draw_line(ili9341_lcd, ILI9341_RED, x, QRS_MARK_Y1, x, QRS_MARK_Y2);
+    drawn_marks[x] = true;
+  }
+  if (scroll_mode) {
+    ili9341_scroll_advance(ili9341_lcd);
+  }
+}
+
+// Saves the adapted detector state for the next session and switches the power off.
+void power_off() {
+  shutdown_requested = false;
+  pt_state_t detector_state;
+  if (get_pan_tompkins_state(&detectors[0], &detector_state)) {
+    settings_save_detector_state(&detector_state);
+  }
+  disableAD();
+  HAL_GPIO_WritePin(GPIOA, GPIO_PIN_3, GPIO_PIN_RESET);
+}
+
 void display_graph() {
+  if (shutdown_requested) {
+    power_off();
+    return;
+  }
   if (enabled) {
-    uint16_t draw_index, previous_draw_index, x;
+    // The LCD takes more than a second to come out of reset. The samples acquired meanwhile are only fed to the
+    // detector, so its learning phase overlaps with the LCD initialization.
+    if (!lcd_ready) {
+      lcd_ready = ili9341_initialize_step(ili9341_lcd);
+      if (!lcd_ready) {
+        handle_lead_off();
+        while (fill_index > current_index) {
+          process_sample();
+          current_index++;
+        }
+        return;
+      }
+      draw_splash();
+      if (lead_off_handled) {
+        ili9341_draw_string(ili9341_lcd, LEAD_OFF_ATTR, LEAD_OFF_TEXTS[1]);
+      }
+    }
+    if (scroll_toggled) {
+      scroll_toggled = false;
+      scroll_mode = !scroll_mode;
+      select_layout();
+    }
+    if (handle_lead_off()) {
+      hold_scroll(true);
+      if (mode == MENU) {
+        draw_menu();
+      }
+      return;
+    }
+    hold_scroll(mode == MENU);
+    if (mode != drawn_mode) {
+      // The menu was drawn over the trace, the sweep erases it column by column.
+      if (mode == MEASURE) {
+        reset_columns(true);
+      }
+      drawn_mode = mode;
+    }
     while (fill_index > current_index) {
       active = true;
       if (!paused) {
-        draw_index = MOD_INDEX(current_index);
-        previous_draw_index = MOD_INDEX(draw_index - 1);
-        x = current_index % ili9341_lcd->screen_size.width;
-        ili9341_draw_line(ili9341_lcd, TEXT_BACKGROUND, x, 0, x, ili9341_lcd->screen_size.height - 1);
-        // draw ruler
-        uint32_t current_time = time_buffer[draw_index];
-        if (current_time % SEC_MOD < 5) {
-          ili9341_draw_line(ili9341_lcd, ILI9341_DARKGREY, x, SEC_RULER_TICK_Y2, x, RULER_TICK_Y1);
+        process_sample();
+        // The trace is drawn DISPLAY_FILTER_DELAY samples behind, when its baseline is known.
+        if (current_index >= DISPLAY_FILTER_DELAY && !scroll_held) {
+          draw_sample(current_index - DISPLAY_FILTER_DELAY);
         }
-        else if (current_time % HALF_SEC_MOD < 5) {
-          ili9341_draw_line(ili9341_lcd, ILI9341_DARKGREY, x, HALF_SEC_RULER_TICK_Y2, x, RULER_TICK_Y1);
-        }
-
-        // draw raw signal
-//        if (x == 0) {
-//          ili9341_draw_pixel(ili9341_lcd, RAW_SIGNAL_COLOR, x, translate_y(raw_values[draw_index]));
-//        }
-//        else {
-//          ili9341_draw_line(ili9341_lcd, RAW_SIGNAL_COLOR, x - 1, translate_y(raw_values[previous_draw_index]), x, translate_y(raw_values[draw_index]));
-//        }
-
-        process_pan_tompkins(raw_values, filtered, current_index, &result);
-
-        // draw filtered signal
-        if (x == 0) {
-          ili9341_draw_pixel(ili9341_lcd, FILTERED_SIGNAL_COLOR, x, translate_y(FILTERED_DC_SHIFT(filtered[draw_index])));
-        }
-        else {
-          ili9341_draw_line(ili9341_lcd, FILTERED_SIGNAL_COLOR, x - 1, translate_y(FILTERED_DC_SHIFT(filtered[previous_draw_index])), x, translate_y(FILTERED_DC_SHIFT(filtered[draw_index])));
-        }
-        if (result.is_qrs) {
-          ili9341_draw_line(ili9341_lcd, ILI9341_RED, x, 210, x, 230);
-        }
-        print_result(&result);
       }
       current_index++;
 //      rotary_index = rotary_index % ili9341_lcd->screen_size.width;
 //      ili9341_draw_line(ili9341_lcd, ILI9341_CYAN, rotary_index, 1, rotary_index, rotary_values[rotary_index] % 240);
 //      rotary_index++;
     }
+    print_beats();
     if (mode == MENU) {
       draw_menu();
     }
@@ -291,21 +667,51 @@ void display_handle_button_press() {
         case MENU_ITEM_PAUSE:
           paused = !paused;
           break;
+        case MENU_ITEM_FILTER:
+          filter_profile = (filter_profile + 1) % DISPLAY_FILTER_PROFILE_COUNT;
+          filter_changed = true;
+          break;
+        case MENU_ITEM_NOTCH:
+          filter_notch = (filter_notch + 1) % DISPLAY_NOTCH_COUNT;
+          filter_changed = true;
+          break;
+        case MENU_ITEM_SCROLL:
+          scroll_toggled = true;
+          break;
         default: mode = MEASURE;
       }
     }
 }
 
+void display_handle_lead_off(bool off) {
+  leads_off = off;
+}
+
+/*
+    Called from the shutdown timer interrupt. The sampling stops at once, the rest is left to the main loop: the
+    detector may be halfway through a sample, and the flash can't be erased from an interrupt.
+*/
 void display_shutdown() {
   enabled = false;
-  disableAD();
-  HAL_GPIO_WritePin(GPIOA, GPIO_PIN_3, GPIO_PIN_RESET);
+  shutdown_requested = true;
+}
+
+void HAL_SPI_TxCpltCallback(SPI_HandleTypeDef *hspi) {
+  if (ili9341_lcd != NULL && hspi == ili9341_lcd->spi_hal) {
+    ili9341_transmit_complete(ili9341_lcd);
+  }
 }
 
 void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim) {
   if (htim->Instance == TIM16) {
     if (enabled) {
-      raw_values[MOD_INDEX(fill_index)] = dma_values[0];
+      for (uint8_t lead = 0; lead < LEAD_COUNT; lead++) {
+        uint32_t sum = 0;
+        for (uint8_t i = 0; i < ADC_DECIMATION; i++) {
+          sum += dma_values[i * LEAD_COUNT + lead];
+        }
+        raw_values[lead][MOD_INDEX(fill_index)] = sum / ADC_DECIMATION;
+      }
       time_buffer[MOD_INDEX(fill_index)] = HAL_GetTick();
       fill_index++;
     }
@@ -0,0 +1,185 @@
+#include "stm32l4xx_hal.h"
+#include <stdbool.h>
+#include <string.h>
+#include "display_filter.h"
+#include "signal_processing.h"
+#include "sliding_median.h"
+
+// The display filter is a cascade of biquad sections in direct form I, on integers. The coefficients are Q28, the
+// accumulator is 64 bit, and the rounding error of each output is carried over to the next one (error feedback),
+// so the sections with a pole close to 1 (the 0.05 Hz high pass) don't drift or get stuck on a limit cycle.
+// The samples are scaled up by INPUT_SHIFT bits for the same reason.
+// After the filters the baseline wander (breathing, motion) is removed: the baseline is the median over 200ms of the
+// filtered signal, which removes the QRS complexes, then the median over 600ms of that, which removes the P and T
+// waves. The baseline belongs to the middle of the windows, so it is subtracted from the filtered signal delayed by
+// DISPLAY_FILTER_DELAY samples.
+
+#define COEFFICIENT_BITS 28
+
+#define INPUT_SHIFT 8
+
+#define MAX_SECTIONS 3 // A profile has at most two sections, plus the notch.
+
+#define NOTCH_Q 5.0 // Quality factor of the notch, 10 Hz wide at 50 Hz.
+
+// The coefficients are computed by the compiler from the corner frequencies, with the formulas of the Audio EQ
+// Cookbook (R. Bristow-Johnson). Math functions can't be called in a constant expression, so sin and cos are
+// Taylor series, accurate to 1e-12 up to 0.6 pi (60 Hz at 200 Hz sampling frequency).
+#define PI 3.14159265358979323846
+
+#define W0(f) (2 * PI * (f) / SAMPLING_FREQUENCY)
+
+#define SQ(x) ((x) * (x))
+
+#define SIN(x) ((x) * (1 - SQ(x) / 6 * (1 - SQ(x) / 20 * (1 - SQ(x) / 42 * (1 - SQ(x) / 72 * (1 - SQ(x) / 110 * \
+    (1 - SQ(x) / 156 * (1 - SQ(x) / 210 * (1 - SQ(x) / 272)))))))))
+
+#define COS(x) (1 - SQ(x) / 2 * (1 - SQ(x) / 12 * (1 - SQ(x) / 30 * (1 - SQ(x) / 56 * (1 - SQ(x) / 90 * \
+    (1 - SQ(x) / 132 * (1 - SQ(x) / 182 * (1 - SQ(x) / 240))))))))
+
+#define ALPHA(f, q) (SIN(W0(f)) / (2 * (q)))
+
+#define Q(x) ((int32_t) ((x) * (1 << COEFFICIENT_BITS) + ((x) >= 0 ? 0.5 : -0.5)))
+
+// Coefficients normalized by a0.
+#define A1(f, q) Q(-2 * COS(W0(f)) / (1 + ALPHA(f, q)))
+#define A2(f, q) Q((1 - ALPHA(f, q)) / (1 + ALPHA(f, q)))
+
+#define LOWPASS_B0(f, q) Q((1 - COS(W0(f))) / 2 / (1 + ALPHA(f, q)))
+#define HIGHPASS_B0(f, q) Q((1 + COS(W0(f))) / 2 / (1 + ALPHA(f, q)))
+#define NOTCH_B0(f, q) Q(1 / (1 + ALPHA(f, q)))
+
+// b1 is derived from the rounded b0, so the zeros stay exactly at DC (high pass) or at the Nyquist frequency (low
+// pass). A high pass filter leaking a tiny bit of DC would shift the trace by tens of counts.
+#define LOWPASS(f, q) { LOWPASS_B0(f, q), 2 * LOWPASS_B0(f, q), LOWPASS_B0(f, q), A1(f, q), A2(f, q) }
+#define HIGHPASS(f, q) { HIGHPASS_B0(f, q), -2 * HIGHPASS_B0(f, q), HIGHPASS_B0(f, q), A1(f, q), A2(f, q) }
+#define NOTCH(f, q) { NOTCH_B0(f, q), A1(f, q), NOTCH_B0(f, q), A1(f, q), A2(f, q) }
+
+#define BUTTERWORTH_Q 0.70710678118654752
+
+#define SHORT_MEDIAN_SIZE (SAMPLING_FREQUENCY / 5 + 1)     // 200ms, odd.
+#define LONG_MEDIAN_SIZE (3 * SAMPLING_FREQUENCY / 5 + 1)  // 600ms, odd.
+
+#if DISPLAY_FILTER_DELAY != SHORT_MEDIAN_SIZE / 2 + LONG_MEDIAN_SIZE / 2
+#error "DISPLAY_FILTER_DELAY must be the delay of the medians"
+#endif
+
+typedef struct {
+  int32_t b0, b1, b2, a1, a2;
+} biquad_coefficients_t;
+
+typedef struct {
+  int32_t x1, x2, y1, y2;
+  int64_t error;
+} biquad_state_t;
+
+typedef struct {
+  uint8_t section_count;
+  biquad_coefficients_t sections[MAX_SECTIONS - 1];
+} display_filter_t;
+
+// The first section of each profile is the high pass, see display_filter_process.
+static const display_filter_t PROFILES[DISPLAY_FILTER_PROFILE_COUNT] = {
+  { 2, { HIGHPASS(0.5, BUTTERWORTH_Q), LOWPASS(40, BUTTERWORTH_Q) } },
+  // 150 Hz is beyond the Nyquist frequency, the bandwidth is limited by the sampling frequency.
+  { 1, { HIGHPASS(0.05, BUTTERWORTH_Q) } }
+};
+
+static const biquad_coefficients_t NOTCHES[DISPLAY_NOTCH_COUNT] = {
+  { 0 },
+  NOTCH(50, NOTCH_Q),
+  NOTCH(60, NOTCH_Q)
+};
+
+// The selected cascade, switching only changes the pointers.
+static const biquad_coefficients_t* cascade[MAX_SECTIONS];
+static uint8_t cascade_length = 0;
+static biquad_state_t states[MAX_SECTIONS];
+static bool primed = false;
+
+static int16_t short_data[SHORT_MEDIAN_SIZE], short_pos[SHORT_MEDIAN_SIZE];
+static uint8_t short_heap[SHORT_MEDIAN_SIZE];
+static sliding_median_t short_median;
+
+static int16_t long_data[LONG_MEDIAN_SIZE], long_pos[LONG_MEDIAN_SIZE];
+static uint8_t long_heap[LONG_MEDIAN_SIZE];
+static sliding_median_t long_median;
+
+// The filtered signal, delayed to the middle of the median windows.
+static int16_t delay_line[DISPLAY_FILTER_DELAY];
+static uint8_t delay_index = 0;
+
+static int16_t clamp_sample(int32_t value) {
+  if (value > INT16_MAX) {
+    return INT16_MAX;
+  }
+  if (value < INT16_MIN) {
+    return INT16_MIN;
+  }
+  return value;
+}
+
+void display_filter_select(display_filter_profile_t profile, display_filter_notch_t notch) {
+  cascade_length = 0;
+  for (uint8_t i = 0; i < PROFILES[profile].section_count; i++) {
+    cascade[cascade_length++] = &PROFILES[profile].sections[i];
+  }
+  if (notch != DISPLAY_NOTCH_OFF) {
+    cascade[cascade_length++] = &NOTCHES[notch];
+  }
+  display_filter_reset();
+}
+
+/*
+    Forgets the history of the filter, e.g. after the signal was interrupted. The next sample restarts it.
+*/
+void display_filter_reset() {
+  memset(states, 0, sizeof(states));
+  sliding_median_init(&short_median, short_data, short_pos, short_heap, SHORT_MEDIAN_SIZE);
+  sliding_median_init(&long_median, long_data, long_pos, long_heap, LONG_MEDIAN_SIZE);
+  primed = false;
+}
+
+static int32_t process_section(const biquad_coefficients_t* c, biquad_state_t* s, int32_t x) {
+  int64_t accumulator = s->error;
+  accumulator += (int64_t) c->b0 * x + (int64_t) c->b1 * s->x1 + (int64_t) c->b2 * s->x2;
+  accumulator -= (int64_t) c->a1 * s->y1 + (int64_t) c->a2 * s->y2;
+  int32_t y = accumulator >> COEFFICIENT_BITS;
+  s->error = accumulator - ((int64_t) y << COEFFICIENT_BITS);
+  s->x2 = s->x1;
+  s->x1 = x;
+  s->y2 = s->y1;
+  s->y1 = y;
+  return y;
+}
+
+/*
+    Filters the next sample of the displayed lead. Returns the sample of DISPLAY_FILTER_DELAY samples before, filtered
+    and without the baseline wander, in ADC counts around 0.
+*/
+int16_t display_filter_process(uint16_t sample) {
+  int32_t value = (int32_t) sample << INPUT_SHIFT;
+  if (!primed) {
+    // The high pass section starts as if the input had been at this level forever, so the trace doesn't start
+    // with a step response lasting for seconds (tens of seconds in the diagnostic profile).
+    states[0].x1 = value;
+    states[0].x2 = value;
+  }
+  for (uint8_t i = 0; i < cascade_length; i++) {
+    value = process_section(cascade[i], &states[i], value);
+  }
+  int16_t filtered = clamp_sample((value + (1 << (INPUT_SHIFT - 1))) >> INPUT_SHIFT);
+  if (!primed) {
+    sliding_median_fill(&short_median, filtered);
+    sliding_median_fill(&long_median, filtered);
+    for (uint8_t i = 0; i < DISPLAY_FILTER_DELAY; i++) {
+      delay_line[i] = filtered;
+    }
+    primed = true;
+  }
+  int16_t baseline = sliding_median_insert(&long_median, sliding_median_insert(&short_median, filtered));
+  int16_t delayed = delay_line[delay_index];
+  delay_line[delay_index] = filtered;
+  delay_index = delay_index + 1 == DISPLAY_FILTER_DELAY ? 0 : delay_index + 1;
+  return clamp_sample(delayed - baseline);
+}
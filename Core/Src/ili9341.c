@@ -14,6 +14,7 @@
 #include "ili9341.h"
 #include "ili9341_gfx.h"
 #include "ili9341_font.h"
+#include "ili9341_ll.h"
 
 // ---------------------------------------------------------- private defines --
 
@@ -45,10 +46,15 @@
 
 static void ili9341_reset(ili9341_t *lcd);
 static void ili9341_initialize(ili9341_t *lcd);
+static void ili9341_initialize_wait(ili9341_t *lcd,
+    ili9341_init_state_t state, uint32_t delay);
+static void ili9341_configure(ili9341_t *lcd);
 static ili9341_two_dimension_t ili9341_screen_size(
     ili9341_screen_orientation_t orientation);
 static uint8_t ili9341_screen_rotation(
     ili9341_screen_orientation_t orientation);
+static ili9341_bool_t ili9341_scroll_reversed(ili9341_t *lcd);
+static void ili9341_scroll_start(ili9341_t *lcd);
 
 static int32_t interp(int32_t x, int32_t x0, int32_t x1, int32_t y0, int32_t y1);
 ili9341_two_dimension_t ili9341_clip_touch_coordinate(ili9341_two_dimension_t coord,
@@ -103,6 +109,8 @@ ili9341_t *ili9341_new(
           lcd->orientation          = orientation;
           lcd->screen_size          = ili9341_screen_size(orientation);
 
+          lcd->fill_remaining       = 0U;
+
           if (touch_support) {
 
             lcd->touch_select_port    = touch_select_port;
@@ -140,6 +148,9 @@ ili9341_t *ili9341_new(
             lcd->touch_pressed_end    = NULL;
           }
 
+          // the display is only usable once ili9341_initialize_step() reports
+          // it ready, so that the caller isn't blocked for the ~1.3 s the
+          // reset sequence takes
           ili9341_initialize(lcd);
         }
       }
@@ -149,6 +160,149 @@ ili9341_t *ili9341_new(
   return lcd;
 }
 
+ili9341_bool_t ili9341_initialize_step(ili9341_t *lcd)
+{
+  if (NULL == lcd)
+    { return ibFalse; }
+
+  if (iisReady == lcd->init_state)
+    { return ibTrue; }
+
+  if (HAL_GetTick() - lcd->init_tick < lcd->init_delay)
+    { return ibFalse; }
+
+  switch (lcd->init_state) {
+    case iisReset:
+      HAL_GPIO_WritePin(lcd->reset_port, lcd->reset_pin, __GPIO_PIN_SET__);
+
+      // ensure both slave lines are open
+      ili9341_spi_tft_release(lcd);
+      ili9341_spi_touch_release(lcd);
+
+      // SOFTWARE RESET
+      ili9341_spi_write_command(lcd, issDisplayTFT, __ILI9341_CMD_SWRESET__);
+      ili9341_ll_invalidate_window(lcd);
+      ili9341_initialize_wait(lcd, iisSoftwareReset, 1000);
+      break;
+
+    case iisSoftwareReset:
+      ili9341_spi_tft_select(lcd);
+      ili9341_configure(lcd);
+
+      // EXIT SLEEP
+      ili9341_spi_write_command(lcd, issNONE, 0x11);
+      ili9341_spi_tft_release(lcd);
+      ili9341_initialize_wait(lcd, iisSleepOut, 120);
+      break;
+
+    case iisSleepOut:
+      ili9341_spi_tft_select(lcd);
+
+      // TURN ON DISPLAY
+      ili9341_spi_write_command(lcd, issNONE, 0x29);
+
+      // MADCTL
+      ili9341_spi_write_command_data(lcd, issNONE, __ILI9341_CMD_MADCTL__,
+          1, (uint8_t[]){ ili9341_screen_rotation(lcd->orientation) });
+      ili9341_ll_invalidate_window(lcd);
+
+      ili9341_spi_tft_release(lcd);
+      lcd->init_state = iisReady;
+      break;
+
+    default:
+      break;
+  }
+
+  return (ili9341_bool_t)(iisReady == lcd->init_state);
+}
+
+// the ILI9341 scrolls along the long side of the panel, so in landscape the
+// frame memory lines are the screen columns: the scrolling area is a strip of
+// columns, the rest of the screen stays fixed. returns false if the strip
+// doesn't fit, or the screen is in portrait.
+ili9341_bool_t ili9341_scroll_define(ili9341_t *lcd, uint16_t x, uint16_t w)
+{
+  if (NULL == lcd)
+    { return ibFalse; }
+
+  uint16_t lines = lcd->screen_size.width;
+  if ((lines < lcd->screen_size.height) || (0U == w) || (x + w > lines))
+    { return ibFalse; }
+
+  lcd->scroll_top    = ibOK(ili9341_scroll_reversed(lcd)) ? (lines - x - w) : x;
+  lcd->scroll_size   = w;
+  lcd->scroll_offset = 0U;
+
+  uint16_t bottom = lines - lcd->scroll_top - w;
+  ili9341_spi_write_command_data(lcd, issDisplayTFT, __ILI9341_CMD_VSCRDEF__, 6,
+      (uint8_t[]){ __MSBYTEu16(lcd->scroll_top), __LSBYTEu16(lcd->scroll_top),
+                   __MSBYTEu16(w),               __LSBYTEu16(w),
+                   __MSBYTEu16(bottom),          __LSBYTEu16(bottom) });
+  ili9341_scroll_start(lcd);
+
+  return ibTrue;
+}
+
+void ili9341_scroll_stop(ili9341_t *lcd)
+{
+  if ((NULL == lcd) || (0U == lcd->scroll_size))
+    { return; }
+
+  // a single scrolling area over the whole screen, not scrolled, shows the
+  // frame memory as it is
+  uint16_t lines = lcd->screen_size.width;
+  lcd->scroll_top    = 0U;
+  lcd->scroll_offset = 0U;
+  ili9341_spi_write_command_data(lcd, issDisplayTFT, __ILI9341_CMD_VSCRDEF__, 6,
+      (uint8_t[]){ 0x00, 0x00, __MSBYTEu16(lines), __LSBYTEu16(lines), 0x00, 0x00 });
+  ili9341_scroll_start(lcd);
+  lcd->scroll_size = 0U;
+}
+
+void ili9341_scroll_rewind(ili9341_t *lcd)
+{
+  if ((NULL == lcd) || (0U == lcd->scroll_size))
+    { return; }
+
+  // the strip shows its columns where they are drawn again
+  lcd->scroll_offset = 0U;
+  ili9341_scroll_start(lcd);
+}
+
+// the frame memory lines of the strip are used as a ring: the column brought
+// in at the right edge of the strip by the next ili9341_scroll_advance() is
+// the one that leaves it at the left edge. returns its x coordinate to draw
+// the new content at, before advancing.
+uint16_t ili9341_scroll_column(ili9341_t *lcd)
+{
+  if ((NULL == lcd) || (0U == lcd->scroll_size))
+    { return 0U; }
+
+  uint16_t line;
+  if (ibOK(ili9341_scroll_reversed(lcd))) {
+    // the columns run against the lines, the right edge is the first line
+    line = lcd->scroll_top +
+        (lcd->scroll_offset + lcd->scroll_size - 1U) % lcd->scroll_size;
+    return lcd->screen_size.width - 1U - line;
+  }
+  line = lcd->scroll_top + lcd->scroll_offset;
+  return line;
+}
+
+// moves the strip one column to the left
+void ili9341_scroll_advance(ili9341_t *lcd)
+{
+  if ((NULL == lcd) || (0U == lcd->scroll_size))
+    { return; }
+
+  if (ibOK(ili9341_scroll_reversed(lcd)))
+    { lcd->scroll_offset = (lcd->scroll_offset + lcd->scroll_size - 1U) % lcd->scroll_size; }
+  else
+    { lcd->scroll_offset = (lcd->scroll_offset + 1U) % lcd->scroll_size; }
+  ili9341_scroll_start(lcd);
+}
+
 void ili9341_touch_interrupt(ili9341_t *lcd)
 {
   uint16_t x_pos;
@@ -257,6 +411,9 @@ ili9341_touch_pressed_t ili9341_touch_coordinate(ili9341_t *lcd,
   // TODO: based on STM32G4, which is clocked at 170MHz. support other chips.
   MODIFY_REG(lcd->spi_hal->Instance->CR1, SPI_CR1_BR, SPI_BAUDRATEPRESCALER_128);
 
+  // the XPT2046 transfers are 8-bit, the TFT may have left 16-bit frames on
+  ili9341_ll_set_frame_size(lcd, SPI_DATASIZE_8BIT);
+
   ili9341_spi_touch_select(lcd);
 
   while ((itpPressed == ili9341_touch_pressed(lcd)) && (sample--)) {
@@ -430,8 +587,7 @@ void ili9341_spi_write_command(ili9341_t *lcd,
 {
   __SLAVE_SELECT(lcd, spi_slave);
 
-  HAL_GPIO_WritePin(lcd->data_command_port, lcd->data_command_pin, __GPIO_PIN_CLR__);
-  HAL_SPI_Transmit(lcd->spi_hal, &command, sizeof(command), __SPI_MAX_DELAY__);
+  ili9341_ll_write_command(lcd, command);
 
   __SLAVE_RELEASE(lcd, spi_slave);
 }
@@ -441,8 +597,7 @@ void ili9341_spi_write_data(ili9341_t *lcd,
 {
   __SLAVE_SELECT(lcd, spi_slave);
 
-  HAL_GPIO_WritePin(lcd->data_command_port, lcd->data_command_pin, __GPIO_PIN_SET__);
-  HAL_SPI_Transmit(lcd->spi_hal, data, data_sz, __SPI_MAX_DELAY__);
+  ili9341_ll_write_data(lcd, data_sz, data);
 
   __SLAVE_RELEASE(lcd, spi_slave);
 }
@@ -475,27 +630,31 @@ void ili9341_spi_write_command_data(ili9341_t *lcd,
 static void ili9341_reset(ili9341_t *lcd)
 {
   // the reset pin on ILI9341 is active low, so driving low temporarily will
-  // reset the device (also resets the touch screen peripheral)
+  // reset the device (also resets the touch screen peripheral). it is driven
+  // high again by ili9341_initialize_step() after 200 ms.
   HAL_GPIO_WritePin(lcd->reset_port, lcd->reset_pin, __GPIO_PIN_CLR__);
-  HAL_Delay(200);
-  HAL_GPIO_WritePin(lcd->reset_port, lcd->reset_pin, __GPIO_PIN_SET__);
-
-  // ensure both slave lines are open
-  ili9341_spi_tft_release(lcd);
-  ili9341_spi_touch_release(lcd);
+  ili9341_ll_invalidate_window(lcd);
+  lcd->scroll_size = 0U;
 }
 
 static void ili9341_initialize(ili9341_t *lcd)
 {
+  // command list is based on https://github.com/martnak/STM32-ILI9341, the
+  // delays between the steps are waited out by ili9341_initialize_step()
   ili9341_reset(lcd);
-  ili9341_spi_tft_select(lcd);
-
-  // command list is based on https://github.com/martnak/STM32-ILI9341
+  ili9341_initialize_wait(lcd, iisReset, 200);
+}
 
-  // SOFTWARE RESET
-  ili9341_spi_write_command(lcd, issNONE, 0x01);
-  HAL_Delay(1000);
+static void ili9341_initialize_wait(ili9341_t *lcd,
+    ili9341_init_state_t state, uint32_t delay)
+{
+  lcd->init_state = state;
+  lcd->init_tick  = HAL_GetTick();
+  lcd->init_delay = delay;
+}
 
+static void ili9341_configure(ili9341_t *lcd)
+{
   // POWER CONTROL A
   ili9341_spi_write_command_data(lcd, issNONE,
       0xCB, 5, (uint8_t[]){ 0x39, 0x2C, 0x00, 0x34, 0x02 });
@@ -569,19 +728,6 @@ static void ili9341_initialize(ili9341_t *lcd)
   ili9341_spi_write_command_data(lcd, issNONE,
       0xE1, 15, (uint8_t[]){ 0x00, 0x0E, 0x14, 0x03, 0x11, 0x07, 0x31, 0xC1,
                              0x48, 0x08, 0x0F, 0x0C, 0x31, 0x36, 0x0F });
-
-  // EXIT SLEEP
-  ili9341_spi_write_command(lcd, issNONE, 0x11);
-  HAL_Delay(120);
-
-  // TURN ON DISPLAY
-  ili9341_spi_write_command(lcd, issNONE, 0x29);
-
-  // MADCTL
-  ili9341_spi_write_command_data(lcd, issNONE,
-      0x36, 1, (uint8_t[]){ ili9341_screen_rotation(lcd->orientation) });
-
-  ili9341_spi_tft_release(lcd);
 }
 
 static ili9341_two_dimension_t ili9341_screen_size(
@@ -616,6 +762,21 @@ static uint8_t ili9341_screen_rotation(
   }
 }
 
+static ili9341_bool_t ili9341_scroll_reversed(ili9341_t *lcd)
+{
+  // with the rows and columns exchanged (MV), the row address order (MY)
+  // decides whether the screen columns run along the frame memory lines or
+  // against them
+  return (ili9341_bool_t)(0U != (ili9341_screen_rotation(lcd->orientation) & 0x80));
+}
+
+static void ili9341_scroll_start(ili9341_t *lcd)
+{
+  uint16_t start = lcd->scroll_top + lcd->scroll_offset;
+  ili9341_spi_write_command_data(lcd, issDisplayTFT, __ILI9341_CMD_VSCRSADD__, 2,
+      (uint8_t[]){ __MSBYTEu16(start), __LSBYTEu16(start) });
+}
+
 static int32_t interp(int32_t x, int32_t x0, int32_t x1, int32_t y0, int32_t y1)
 {
   if (x1 == x0)
@@ -0,0 +1,172 @@
+/*
+ * ili9341_font_aa.c
+ *
+ * Generated by Tools/ili9341_fontgen, do not edit.
+ */
+
+// ----------------------------------------------------------------- includes --
+
+#include "ili9341_font.h"
+
+// ------------------------------------------------------- private variables --
+
+static uint8_t const ili9341_font_aa_22x36_data[] = {
+  // ' '
+  0x3F, 0x3F, 0x3F, 0x3F, 0x3F, 0x3F, 0x3F, 0x3F, 0x3F, 0x3F, 0x3F, 0x3F,
+  0x17,
+  // '-'
+  0x3F, 0x3F, 0x3F, 0x3F, 0x3F, 0x23, 0x40, 0xCB, 0x40, 0x07, 0x80, 0xCB,
+  0x80, 0x07, 0x80, 0xCB, 0x80, 0x07, 0x40, 0xCB, 0x40, 0x3F, 0x3F, 0x3F,
+  0x3F, 0x3F, 0x23,
+  // '0'
+  0x1E, 0x40, 0x81, 0x40, 0x0F, 0x40, 0xC5, 0x40, 0x0C, 0x40, 0xC7, 0x40,
+  0x0A, 0x40, 0xC9, 0x40, 0x09, 0xC4, 0x81, 0xC4, 0x08, 0x80, 0xC3, 0x40,
+  0x01, 0x40, 0xC3, 0x80, 0x07, 0xC3, 0x40, 0x03, 0x40, 0xC3, 0x06, 0x40,
+  0xC3, 0x05, 0xC3, 0x40, 0x05, 0x80, 0xC2, 0x40, 0x05, 0x40, 0xC2, 0x80,
+  0x05, 0xC3, 0x07, 0xC3, 0x04, 0x40, 0xC2, 0x80, 0x07, 0x80, 0xC2, 0x40,
+  0x03, 0x80, 0xC2, 0x80, 0x07, 0x80, 0xC2, 0x80, 0x03, 0x80, 0xC2, 0x40,
+  0x07, 0x40, 0xC2, 0x80, 0x03, 0x80, 0xC2, 0x40, 0x07, 0x40, 0xC2, 0x80,
+  0x03, 0xC3, 0x09, 0xC3, 0x03, 0xC3, 0x09, 0xC3, 0x03, 0xC3, 0x09, 0xC3,
+  0x03, 0xC3, 0x09, 0xC3, 0x03, 0xC3, 0x09, 0xC3, 0x03, 0xC3, 0x09, 0xC3,
+  0x03, 0x80, 0xC2, 0x40, 0x07, 0x40, 0xC2, 0x80, 0x03, 0x80, 0xC2, 0x40,
+  0x07, 0x40, 0xC2, 0x80, 0x03, 0x80, 0xC2, 0x80, 0x07, 0x80, 0xC2, 0x80,
+  0x03, 0x40, 0xC2, 0x80, 0x07, 0x80, 0xC2, 0x40, 0x04, 0xC3, 0x07, 0xC3,
+  0x05, 0x80, 0xC2, 0x40, 0x05, 0x40, 0xC2, 0x80, 0x05, 0x40, 0xC3, 0x05,
+  0xC3, 0x40, 0x06, 0xC3, 0x40, 0x03, 0x40, 0xC3, 0x07, 0x80, 0xC3, 0x40,
+  0x01, 0x40, 0xC3, 0x80, 0x08, 0xC4, 0x81, 0xC4, 0x09, 0x40, 0xC9, 0x40,
+  0x0A, 0x40, 0xC7, 0x40, 0x0C, 0x40, 0xC5, 0x40, 0x0F, 0x40, 0x81, 0x40,
+  0x1E,
+  // '1'
+  0x1F, 0x41, 0x12, 0x80, 0xC1, 0x80, 0x10, 0x80, 0xC3, 0x0F, 0x80, 0xC4,
+  0x0E, 0x80, 0xC5, 0x0D, 0x80, 0xC6, 0x0C, 0x40, 0xC7, 0x0C, 0x40, 0xC2,
+  0x80, 0xC3, 0x0D, 0x82, 0x00, 0xC3, 0x11, 0xC3, 0x11, 0xC3, 0x11, 0xC3,
+  0x11, 0xC3, 0x11, 0xC3, 0x11, 0xC3, 0x11, 0xC3, 0x11, 0xC3, 0x11, 0xC3,
+  0x11, 0xC3, 0x11, 0xC3, 0x11, 0xC3, 0x11, 0xC3, 0x11, 0xC3, 0x11, 0xC3,
+  0x11, 0xC3, 0x11, 0xC3, 0x11, 0xC3, 0x11, 0xC3, 0x11, 0xC3, 0x11, 0xC3,
+  0x11, 0xC3, 0x11, 0xC3, 0x11, 0x80, 0xC1, 0x80, 0x12, 0x41, 0x1F,
+  // '2'
+  0x1E, 0x40, 0x81, 0x40, 0x0E, 0x40, 0x80, 0xC5, 0x80, 0x40, 0x0A, 0x80,
+  0xC9, 0x80, 0x08, 0x80, 0xCB, 0x80, 0x06, 0x80, 0xC4, 0x83, 0xC4, 0x80,
+  0x05, 0xC3, 0x80, 0x40, 0x03, 0x40, 0x80, 0xC3, 0x04, 0x40, 0xC3, 0x07,
+  0xC3, 0x40, 0x03, 0x80, 0xC2, 0x40, 0x07, 0x40, 0xC2, 0x80, 0x04, 0xC1,
+  0x80, 0x09, 0xC3, 0x11, 0xC3, 0x11, 0xC3, 0x10, 0x40, 0xC2, 0x80, 0x10,
+  0xC3, 0x80, 0x0F, 0x80, 0xC3, 0x0F, 0x40, 0xC3, 0x80, 0x0F, 0xC3, 0x80,
+  0x0F, 0x80, 0xC3, 0x0F, 0x80, 0xC3, 0x40, 0x0E, 0x40, 0xC3, 0x80, 0x0F,
+  0xC4, 0x0F, 0x80, 0xC3, 0x40, 0x0E, 0x40, 0xC3, 0x80, 0x0F, 0xC3, 0x80,
+  0x0F, 0x80, 0xC3, 0x0F, 0x80, 0xC3, 0x40, 0x0E, 0x40, 0xC3, 0x80, 0x0F,
+  0xC4, 0x0F, 0x80, 0xC3, 0x40, 0x0E, 0x40, 0xC3, 0x80, 0x0F, 0xC4, 0x89,
+  0x40, 0x04, 0x80, 0xCF, 0x80, 0x03, 0xD1, 0x03, 0x80, 0xCF, 0x80, 0x04,
+  0x40, 0x8D, 0x40, 0x18,
+  // '3'
+  0x1E, 0x40, 0x81, 0x40, 0x0E, 0x40, 0x80, 0xC5, 0x80, 0x40, 0x0A, 0x40,
+  0xC9, 0x40, 0x08, 0x40, 0xCB, 0x40, 0x06, 0x40, 0xC4, 0x83, 0xC4, 0x40,
+  0x05, 0x80, 0xC3, 0x40, 0x03, 0x40, 0xC3, 0x80, 0x05, 0x80, 0xC2, 0x40,
+  0x05, 0x40, 0xC3, 0x40, 0x04, 0x40, 0xC1, 0x80, 0x07, 0x80, 0xC2, 0x80,
+  0x10, 0x40, 0xC2, 0x80, 0x10, 0x40, 0xC2, 0x80, 0x10, 0x40, 0xC2, 0x80,
+  0x10, 0x40, 0xC2, 0x80, 0x10, 0xC3, 0x40, 0x0F, 0x80, 0xC3, 0x0E, 0x40,
+  0x80, 0xC3, 0x80, 0x0B, 0x40, 0xC6, 0x80, 0x0C, 0xC6, 0x80, 0x0D, 0xC7,
+  0x40, 0x0C, 0x40, 0xC7, 0x0F, 0x40, 0x80, 0xC3, 0x80, 0x10, 0x40, 0xC3,
+  0x40, 0x10, 0x80, 0xC2, 0x80, 0x10, 0x40, 0xC3, 0x11, 0xC3, 0x11, 0xC3,
+  0x11, 0xC3, 0x04, 0x80, 0xC1, 0x40, 0x07, 0x40, 0xC2, 0x80, 0x04, 0xC3,
+  0x07, 0xC3, 0x40, 0x04, 0xC3, 0x80, 0x40, 0x03, 0x40, 0x80, 0xC3, 0x05,
+  0x40, 0xC4, 0x83, 0xC4, 0x40, 0x06, 0x80, 0xCB, 0x80, 0x08, 0x80, 0xC9,
+  0x80, 0x0A, 0x40, 0x80, 0xC5, 0x80, 0x40, 0x0E, 0x40, 0x81, 0x40, 0x1E,
+  // '4'
+  0x22, 0x41, 0x12, 0x80, 0xC1, 0x80, 0x11, 0xC3, 0x10, 0x80, 0xC3, 0x10,
+  0xC4, 0x0F, 0x80, 0xC4, 0x0F, 0xC5, 0x0E, 0x80, 0xC5, 0x0E, 0xC6, 0x0D,
+  0x80, 0xC6, 0x0D, 0xC7, 0x0C, 0x40, 0xC7, 0x0C, 0xC3, 0x80, 0xC3, 0x0B,
+  0x40, 0xC3, 0x00, 0xC3, 0x0B, 0xC3, 0x80, 0x00, 0xC3, 0x0A, 0x40, 0xC3,
+  0x01, 0xC3, 0x0A, 0xC3, 0x80, 0x01, 0xC3, 0x09, 0x40, 0xC3, 0x02, 0xC3,
+  0x09, 0x80, 0xC2, 0x80, 0x02, 0xC3, 0x08, 0x40, 0xC3, 0x03, 0xC3, 0x08,
+  0x80, 0xC2, 0x80, 0x03, 0xC3, 0x07, 0x40, 0xC3, 0x84, 0xC3, 0x81, 0x40,
+  0x04, 0x80, 0xD0, 0x03, 0xD1, 0x80, 0x02, 0x80, 0xD0, 0x40, 0x03, 0x88,
+  0xC3, 0x82, 0x40, 0x0D, 0xC3, 0x11, 0xC3, 0x11, 0xC3, 0x11, 0xC3, 0x11,
+  0xC3, 0x11, 0xC3, 0x11, 0x80, 0xC1, 0x80, 0x12, 0x41, 0x1C,
+  // '5'
+  0x1A, 0x40, 0x8A, 0x40, 0x07, 0xCD, 0x80, 0x05, 0x40, 0xCE, 0x05, 0x40,
+  0xCD, 0x80, 0x05, 0x40, 0xC3, 0x88, 0x40, 0x06, 0x40, 0xC2, 0x80, 0x10,
+  0x40, 0xC2, 0x80, 0x10, 0x80, 0xC2, 0x80, 0x10, 0x80, 0xC2, 0x80, 0x10,
+  0x80, 0xC2, 0x80, 0x10, 0x80, 0xC2, 0x80, 0x10, 0x80, 0xC2, 0x80, 0x10,
+  0x80, 0xC2, 0x81, 0xC2, 0x81, 0x0A, 0x80, 0xCA, 0x40, 0x08, 0x80, 0xCB,
+  0x80, 0x07, 0x80, 0xCC, 0x40, 0x06, 0x80, 0xC3, 0x80, 0x02, 0x40, 0xC4,
+  0x06, 0x40, 0xC2, 0x40, 0x04, 0x40, 0xC3, 0x80, 0x06, 0x40, 0x80, 0x07,
+  0x40, 0xC3, 0x11, 0x80, 0xC2, 0x40, 0x10, 0x40, 0xC2, 0x80, 0x10, 0x40,
+  0xC2, 0x80, 0x10, 0x40, 0xC2, 0x80, 0x10, 0x40, 0xC2, 0x80, 0x10, 0x40,
+  0xC2, 0x80, 0x04, 0x81, 0x40, 0x08, 0x80, 0xC2, 0x80, 0x03, 0x80, 0xC2,
+  0x40, 0x07, 0xC3, 0x40, 0x03, 0x80, 0xC2, 0x80, 0x06, 0x80, 0xC3, 0x04,
+  0x40, 0xC3, 0x80, 0x04, 0x80, 0xC3, 0x40, 0x05, 0x80, 0xC4, 0x82, 0xC4,
+  0x80, 0x07, 0x80, 0xCA, 0x80, 0x09, 0x80, 0xC8, 0x80, 0x0B, 0x40, 0xC6,
+  0x40, 0x0E, 0x41, 0x80, 0x41, 0x1E,
+  // '6'
+  0x24, 0x40, 0x12, 0x80, 0xC2, 0x0F, 0x80, 0xC4, 0x80, 0x0C, 0x40, 0x80,
+  0xC5, 0x40, 0x0B, 0x40, 0xC6, 0x80, 0x0B, 0x40, 0xC5, 0x40, 0x0D, 0xC4,
+  0x80, 0x0E, 0x80, 0xC3, 0x40, 0x0E, 0x40, 0xC3, 0x80, 0x0F, 0xC3, 0x80,
+  0x0F, 0x40, 0xC3, 0x10, 0xC3, 0x80, 0x0F, 0x40, 0xC3, 0x80, 0xC3, 0x80,
+  0x40, 0x09, 0x80, 0xCA, 0x80, 0x08, 0xCC, 0x80, 0x07, 0xCD, 0x80, 0x05,
+  0x40, 0xC4, 0x80, 0x40, 0x01, 0x40, 0x80, 0xC3, 0x40, 0x04, 0x80, 0xC3,
+  0x80, 0x05, 0x80, 0xC3, 0x04, 0x80, 0xC3, 0x07, 0xC3, 0x40, 0x03, 0x80,
+  0xC2, 0x80, 0x07, 0x80, 0xC2, 0x80, 0x03, 0xC3, 0x40, 0x07, 0x40, 0xC2,
+  0x80, 0x03, 0xC3, 0x09, 0xC3, 0x03, 0xC3, 0x09, 0xC3, 0x03, 0xC3, 0x09,
+  0xC3, 0x03, 0xC3, 0x09, 0xC3, 0x03, 0x80, 0xC2, 0x40, 0x07, 0x40, 0xC2,
+  0x80, 0x03, 0x40, 0xC3, 0x07, 0xC3, 0x40, 0x04, 0xC3, 0x40, 0x05, 0x40,
+  0xC3, 0x05, 0x80, 0xC3, 0x40, 0x03, 0x40, 0xC3, 0x80, 0x06, 0xC4, 0x83,
+  0xC4, 0x07, 0x40, 0xCB, 0x40, 0x08, 0x40, 0xC9, 0x40, 0x0B, 0x80, 0xC5,
+  0x80, 0x0F, 0x40, 0x81, 0x40, 0x1E,
+  // '7'
+  0x18, 0x40, 0x8D, 0x40, 0x04, 0x80, 0xCF, 0x80, 0x03, 0xD1, 0x03, 0x80,
+  0xCF, 0x80, 0x04, 0x40, 0x8A, 0xC3, 0x40, 0x10, 0xC3, 0x10, 0x40, 0xC2,
+  0x80, 0x10, 0x80, 0xC2, 0x40, 0x10, 0xC3, 0x10, 0x40, 0xC2, 0x80, 0x10,
+  0x80, 0xC2, 0x40, 0x10, 0xC3, 0x10, 0x40, 0xC2, 0x80, 0x10, 0x80, 0xC2,
+  0x40, 0x10, 0xC3, 0x10, 0x40, 0xC2, 0x80, 0x10, 0x80, 0xC2, 0x40, 0x10,
+  0xC3, 0x10, 0x40, 0xC2, 0x80, 0x10, 0x80, 0xC2, 0x40, 0x10, 0xC3, 0x10,
+  0x40, 0xC2, 0x80, 0x10, 0x80, 0xC2, 0x40, 0x10, 0xC3, 0x10, 0x40, 0xC2,
+  0x80, 0x10, 0x80, 0xC2, 0x40, 0x10, 0xC3, 0x10, 0x40, 0xC2, 0x80, 0x10,
+  0x80, 0xC2, 0x40, 0x10, 0xC3, 0x10, 0x40, 0xC2, 0x80, 0x10, 0x80, 0xC2,
+  0x40, 0x10, 0x40, 0xC2, 0x12, 0x40, 0x80, 0x22,
+  // '8'
+  0x1E, 0x40, 0x81, 0x40, 0x0F, 0x80, 0xC5, 0x80, 0x0B, 0x40, 0xC9, 0x40,
+  0x09, 0xCB, 0x08, 0x80, 0xC4, 0x81, 0xC4, 0x80, 0x06, 0x40, 0xC3, 0x80,
+  0x03, 0x80, 0xC3, 0x40, 0x05, 0x80, 0xC2, 0x80, 0x05, 0x80, 0xC2, 0x80,
+  0x05, 0xC3, 0x40, 0x05, 0x40, 0xC3, 0x05, 0xC3, 0x07, 0xC3, 0x04, 0x40,
+  0xC2, 0x80, 0x07, 0x80, 0xC2, 0x40, 0x04, 0xC3, 0x07, 0xC3, 0x05, 0xC3,
+  0x07, 0xC3, 0x05, 0x80, 0xC2, 0x80, 0x05, 0x80, 0xC2, 0x80, 0x05, 0x40,
+  0xC3, 0x40, 0x03, 0x40, 0xC3, 0x40, 0x06, 0x80, 0xC3, 0x83, 0xC3, 0x80,
+  0x07, 0x40, 0xCB, 0x40, 0x08, 0x80, 0xC9, 0x80, 0x08, 0x80, 0xCB, 0x80,
+  0x06, 0x40, 0xC4, 0x83, 0xC4, 0x40, 0x05, 0xC4, 0x40, 0x03, 0x40, 0xC4,
+  0x04, 0x40, 0xC3, 0x40, 0x05, 0x40, 0xC3, 0x40, 0x03, 0x80, 0xC2, 0x80,
+  0x07, 0x80, 0xC2, 0x80, 0x03, 0xC3, 0x09, 0xC3, 0x03, 0xC3, 0x09, 0xC3,
+  0x03, 0xC3, 0x09, 0xC3, 0x03, 0xC3, 0x09, 0xC3, 0x03, 0x80, 0xC2, 0x80,
+  0x07, 0x80, 0xC2, 0x80, 0x03, 0x40, 0xC3, 0x40, 0x05, 0x40, 0xC3, 0x40,
+  0x04, 0xC4, 0x40, 0x03, 0x40, 0xC4, 0x05, 0x40, 0xC4, 0x83, 0xC4, 0x40,
+  0x06, 0x80, 0xCB, 0x80, 0x08, 0x80, 0xC9, 0x80, 0x0A, 0x40, 0x80, 0xC5,
+  0x80, 0x40, 0x0E, 0x40, 0x81, 0x40, 0x1E,
+  // '9'
+  0x1E, 0x40, 0x81, 0x40, 0x0F, 0x80, 0xC5, 0x80, 0x0B, 0x40, 0xC9, 0x40,
+  0x08, 0x40, 0xCB, 0x40, 0x07, 0xC4, 0x83, 0xC4, 0x06, 0x80, 0xC3, 0x40,
+  0x03, 0x40, 0xC3, 0x80, 0x05, 0xC3, 0x40, 0x05, 0x40, 0xC3, 0x04, 0x40,
+  0xC3, 0x07, 0xC3, 0x40, 0x03, 0x80, 0xC2, 0x40, 0x07, 0x40, 0xC2, 0x80,
+  0x03, 0xC3, 0x09, 0xC3, 0x03, 0xC3, 0x09, 0xC3, 0x03, 0xC3, 0x09, 0xC3,
+  0x03, 0xC3, 0x09, 0xC3, 0x03, 0x80, 0xC2, 0x40, 0x07, 0x40, 0xC3, 0x03,
+  0x80, 0xC2, 0x80, 0x07, 0x80, 0xC2, 0x80, 0x03, 0x40, 0xC3, 0x07, 0xC3,
+  0x80, 0x04, 0xC3, 0x80, 0x05, 0x80, 0xC3, 0x80, 0x04, 0x40, 0xC3, 0x80,
+  0x40, 0x01, 0x40, 0x80, 0xC4, 0x40, 0x05, 0x80, 0xCD, 0x07, 0x80, 0xCC,
+  0x08, 0x80, 0xCA, 0x80, 0x09, 0x40, 0x80, 0xC3, 0x80, 0xC3, 0x40, 0x0F,
+  0x80, 0xC3, 0x10, 0xC3, 0x40, 0x0F, 0x80, 0xC3, 0x0F, 0x80, 0xC3, 0x40,
+  0x0E, 0x40, 0xC3, 0x80, 0x0E, 0x80, 0xC4, 0x0D, 0x40, 0xC5, 0x40, 0x0B,
+  0x80, 0xC6, 0x40, 0x0B, 0x40, 0xC5, 0x80, 0x40, 0x0C, 0x80, 0xC4, 0x80,
+  0x0F, 0xC2, 0x80, 0x12, 0x40, 0x24,
+};
+
+static uint16_t const ili9341_font_aa_22x36_offset[] = {
+  0, 13, 40, 233, 316, 452, 608, 726, 888, 1050, 1166, 1353, 1515,
+};
+
+// ------------------------------------------------------- exported variables --
+
+ili9341_aa_font_t const ili9341_font_aa_22x36 = {
+  .width  = 22,
+  .height = 36,
+  .chars  = " -0123456789",
+  .offset = ili9341_font_aa_22x36_offset,
+  .data   = ili9341_font_aa_22x36_data,
+};
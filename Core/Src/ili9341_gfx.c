@@ -8,6 +8,7 @@
 // ----------------------------------------------------------------- includes --
 
 #include "ili9341_gfx.h"
+#include "ili9341_ll.h"
 #include "stdlib.h"
 #include "string.h" // memset()
 
@@ -21,7 +22,14 @@
 
 // ----------------------------------------------------------- private types --
 
-/* nothing */
+// position in the runs of a glyph, a row of it is decoded at a time
+typedef struct
+{
+  uint8_t const *run;
+  uint8_t level;
+  uint8_t remaining;
+}
+ili9341_aa_decoder_t;
 
 // ------------------------------------------------------- exported variables --
 
@@ -49,12 +57,26 @@ ili9341_color_t const ILI9341_PINK         = (ili9341_color_t)0xF81F;
 
 static uint16_t spi_tx_block[__SPI_TX_BLOCK_MAX__]; // default DMA TX buffer
 
+static ili9341_glyph_cache_t const *glyph_cache = NULL; // see ili9341_set_glyph_cache()
+
 // ------------------------------------------------------ function prototypes --
 
 static ili9341_bool_t ili9341_clip_rect(ili9341_t *lcd,
     int16_t *x, int16_t *y, uint16_t *w, uint16_t *h);
 static void ili9341_fill_quarter_circle(ili9341_t *lcd, ili9341_color_t color,
     int16_t x, int16_t y, int16_t r, uint8_t corners, int16_t delta);
+static void ili9341_transmit_fill_next(ili9341_t *lcd);
+static void ili9341_render_glyph(ili9341_font_t const *font,
+    ili9341_color_t fg_color, ili9341_color_t bg_color, char ch, uint16_t pixels[]);
+static uint16_t const *ili9341_cached_glyph(ili9341_text_attr_t const *attr, char ch);
+static ili9341_bool_t ili9341_draw_string_window(ili9341_t *lcd,
+    ili9341_text_attr_t const *attr, char const str[]);
+static void ili9341_draw_span(ili9341_t *lcd, ili9341_color_t color,
+    ili9341_bool_t is_steep, int16_t major0, int16_t major1, int16_t minor);
+static ili9341_color_t ili9341_blend(ili9341_color_t fg_color,
+    ili9341_color_t bg_color, uint8_t level);
+static void ili9341_aa_decode(ili9341_aa_decoder_t *decoder,
+    ili9341_color_t const palette[], uint16_t pixels[], uint32_t count);
 
 // ------------------------------------------------------- exported functions --
 
@@ -96,18 +118,8 @@ void ili9341_spi_tft_set_address_rect(ili9341_t *lcd,
 {
   ili9341_spi_tft_select(lcd);
 
-  // column address set
-  ili9341_spi_write_command_data(lcd, issNONE,
-      0x2A, 4, (uint8_t[]){ (x0 >> 8) & 0xFF, x0 & 0xFF,
-                            (x1 >> 8) & 0xFF, x1 & 0xFF });
-
-  // row address set
-  ili9341_spi_write_command_data(lcd, issNONE,
-      0x2B, 4, (uint8_t[]){ (y0 >> 8) & 0xFF, y0 & 0xFF,
-                            (y1 >> 8) & 0xFF, y1 & 0xFF });
-
-  // write to RAM
-  ili9341_spi_write_command(lcd, issNONE, 0x2C);
+  // column/row address set (when changed) and write to RAM
+  ili9341_ll_set_window(lcd, x0, y0, x1, y1);
 
   ili9341_spi_tft_release(lcd);
 }
@@ -117,37 +129,69 @@ void ili9341_transmit_wait(ili9341_t *lcd)
   if (NULL == lcd)
     { return; }
 
-  while (HAL_DMA_STATE_BUSY == HAL_DMA_GetState(lcd->spi_hal->hdmatx))
+  // between the chunks of a fill the DMA is idle, but words remain
+  while ((lcd->fill_remaining > 0U) ||
+         (HAL_DMA_STATE_BUSY == HAL_DMA_GetState(lcd->spi_hal->hdmatx)))
     { continue; }
 }
 
-void ili9341_transmit_color(ili9341_t *lcd, uint16_t size,
-    uint16_t color[]/* already byte-swapped (LE) */, ili9341_bool_t wait)
+void ili9341_transmit_color(ili9341_t *lcd, uint16_t count/* 16-bit words */,
+    uint16_t color[]/* native RGB565 */, ili9341_bool_t wait)
 {
-  if ((NULL == lcd) || (0 == size) || (NULL == color))
+  if ((NULL == lcd) || (0 == count) || (NULL == color))
     { return; }
 
-  HAL_SPI_Transmit_DMA(lcd->spi_hal, (uint8_t *)color, size);
+  ili9341_ll_set_frame_size(lcd, SPI_DATASIZE_16BIT);
+  ili9341_ll_set_dma_source(lcd, ibTrue);
+  HAL_SPI_Transmit_DMA(lcd->spi_hal, (uint8_t *)color, count);
 
   if (ibOK(wait))
     { ili9341_transmit_wait(lcd); }
 }
 
+void ili9341_transmit_fill(ili9341_t *lcd, uint32_t count/* 16-bit words */,
+    uint16_t color/* native RGB565 */, ili9341_bool_t wait)
+{
+  if ((NULL == lcd) || (0U == count))
+    { return; }
+
+  ili9341_transmit_wait(lcd);
+
+  // the DMA repeats the one word without incrementing the source address, in
+  // chunks as large as the HAL allows, each started from the completion of
+  // the previous one (ili9341_transmit_complete())
+  lcd->fill_color     = color;
+  lcd->fill_remaining = count;
+  ili9341_ll_set_frame_size(lcd, SPI_DATASIZE_16BIT);
+  ili9341_ll_set_dma_source(lcd, ibFalse);
+  ili9341_transmit_fill_next(lcd);
+
+  if (ibOK(wait))
+    { ili9341_transmit_wait(lcd); }
+}
+
+void ili9341_transmit_complete(ili9341_t *lcd)
+{
+  // called from HAL_SPI_TxCpltCallback()
+  if ((NULL == lcd) || (0U == lcd->fill_remaining))
+    { return; }
+
+  ili9341_transmit_fill_next(lcd);
+}
+
 void ili9341_draw_pixel(ili9341_t *lcd, ili9341_color_t color,
     int16_t x, int16_t y)
 {
   if (ibNOT(ili9341_clip_rect(lcd, &x, &y, NULL, NULL)))
     { return; }
 
-  uint16_t color_le = __LEu16(&color);
-
-  // select target region
-  ili9341_spi_tft_set_address_rect(lcd, x, y, x + 1, y + 1);
-
   ili9341_spi_tft_select(lcd);
 
-  HAL_GPIO_WritePin(lcd->data_command_port, lcd->data_command_pin, __GPIO_PIN_SET__);
-  HAL_SPI_Transmit(lcd->spi_hal, (uint8_t *)&color_le, 2U, __SPI_MAX_DELAY__);
+  // select target region, a single pixel: consecutive pixels of a vertical
+  // or horizontal line share the column or the row range, respectively
+  ili9341_ll_set_window(lcd, x, y, x, y);
+  ili9341_ll_write_data(lcd, 2U,
+      (uint8_t[]){ __MSBYTEu16(color), __LSBYTEu16(color) });
 
   ili9341_spi_tft_release(lcd);
 }
@@ -158,7 +202,6 @@ void ili9341_draw_line(ili9341_t *lcd, ili9341_color_t color,
   int16_t dx = x1 - x0;
   int16_t dy = y1 - y0;
 
-  int16_t x, y;
   int16_t err;
   int16_t step;
 
@@ -197,25 +240,21 @@ void ili9341_draw_line(ili9341_t *lcd, ili9341_color_t color,
   else
     { step = -1; }
 
+  // the pixels sharing a minor coordinate form a run along the major axis,
+  // which is drawn as a single span (one address window and one transfer)
+  // instead of pixel by pixel. a steep line of n pixels spanning m columns
+  // costs m transfers rather than n.
+  int16_t run = x0;
   while (x0 <= x1) {
 
-    if (is_steep)
-      { x = y0; y = x0; }
-    else
-      { x = x0; y = y0; }
-
-    // continue algorithm even if current pixel is outside of screen
-    // bounds, so that the line is drawn at correct position once
-    // it actually enters screen bounds (if ever).
-    if ( (x >= 0) && (x <= lcd->screen_size.width) &&
-         (y >= 0) && (y <= lcd->screen_size.height) ) {
-      ili9341_draw_pixel(lcd, color, x, y);
-    }
-
     err -= dy;
-    if (err < 0) {
-      y0 += step;
-      err += dx;
+    if ((err < 0) || (x0 == x1)) {
+      ili9341_draw_span(lcd, color, is_steep, run, x0, y0);
+      run = x0 + 1;
+      if (err < 0) {
+        y0 += step;
+        err += dx;
+      }
     }
 
     ++x0;
@@ -239,16 +278,6 @@ void ili9341_fill_rect(ili9341_t *lcd, ili9341_color_t color,
     { return; }
 
   uint32_t num_pixels = w * h;
-  uint32_t rect_wc    = num_pixels;
-
-  uint32_t block_wc = rect_wc;
-  if (block_wc > __SPI_TX_BLOCK_MAX__)
-    { block_wc = __SPI_TX_BLOCK_MAX__; }
-
-  // fill entire block with ordered color data
-  uint16_t color_le = __LEu16(&color);
-  for (uint16_t i = 0; i < block_wc; ++i)
-    { spi_tx_block[i] = color_le; }
 
   // select target region
   ili9341_spi_tft_set_address_rect(lcd, x, y, (x + w - 1), (y + h - 1));
@@ -256,16 +285,9 @@ void ili9341_fill_rect(ili9341_t *lcd, ili9341_color_t color,
 
   HAL_GPIO_WritePin(lcd->data_command_port, lcd->data_command_pin, __GPIO_PIN_SET__);
 
-  // repeatedly send MIN(remaining-words, block-words) words of color data until
-  // all rect words have been sent.
-  uint32_t curr_wc;
-  while (rect_wc > 0) {
-    curr_wc = rect_wc;
-    if (curr_wc > block_wc)
-      { curr_wc = block_wc; }
-    ili9341_transmit_color(lcd, curr_wc * 2/*16-bit words*/, spi_tx_block, ibYes);
-    rect_wc -= curr_wc;
-  }
+  // a solid color doesn't need a pattern buffer, the DMA repeats a single
+  // word for all of the rect
+  ili9341_transmit_fill(lcd, num_pixels, color, ibYes);
 
   ili9341_spi_tft_release(lcd);
 }
@@ -336,9 +358,6 @@ void ili9341_draw_bitmap_1b(ili9341_t *lcd,
   int16_t byteWidth = (w + 7) / 8;
   uint8_t byte = 0;
 
-  uint16_t fg_le = __LEu16(&(fg_color));
-  uint16_t bg_le = __LEu16(&(bg_color));
-
   // select target region
   ili9341_spi_tft_set_address_rect(lcd, x, y, w, h);
   ili9341_spi_tft_select(lcd);
@@ -354,13 +373,13 @@ void ili9341_draw_bitmap_1b(ili9341_t *lcd,
         { byte = bmp[j * byteWidth + i / 8]; }
 
       if (byte & 0x80)
-        { spi_tx_block[((j&1) * w) + i] = fg_le; }
+        { spi_tx_block[((j&1) * w) + i] = fg_color; }
       else
-        { spi_tx_block[((j&1) * w) + i] = bg_le; }
+        { spi_tx_block[((j&1) * w) + i] = bg_color; }
     }
 
     ili9341_transmit_wait(lcd);
-    ili9341_transmit_color(lcd, w * 2, &(spi_tx_block[(j&1) * w]), ibNo);
+    ili9341_transmit_color(lcd, w, &(spi_tx_block[(j&1) * w]), ibNo);
   }
 
   ili9341_spi_tft_release(lcd);
@@ -381,23 +400,20 @@ void ili9341_draw_char(ili9341_t *lcd, ili9341_text_attr_t attr, char ch)
   uint32_t num_pixels = attr.font->width * attr.font->height;
   uint32_t rect_wc    = num_pixels;
 
-  uint16_t fg_le = __LEu16(&(attr.fg_color));
-  uint16_t bg_le = __LEu16(&(attr.bg_color));
-
   uint32_t block_wc = rect_wc;
   if (block_wc > __SPI_TX_BLOCK_MAX__)
     { block_wc = __SPI_TX_BLOCK_MAX__; }
 
-  // initialize the buffer with glyph from selected font
-  uint8_t ch_index = glyph_index(ch);
-  for (uint32_t yi = 0; yi < attr.font->height; ++yi) {
-    uint32_t gl = (uint32_t)attr.font->glyph[ch_index * attr.font->height + yi];
-    for (uint32_t xi = 0; xi < attr.font->width; ++xi) {
-      if ((gl << xi) & 0x8000)
-        { spi_tx_block[yi * attr.font->width + xi] = fg_le; }
-      else
-        { spi_tx_block[yi * attr.font->width + xi] = bg_le; }
-    }
+  // a cached glyph is sent as it is, otherwise the buffer is initialized with
+  // the glyph from selected font
+  uint16_t const *pixels = ili9341_cached_glyph(&attr, ch);
+  if (NULL == pixels) {
+    ili9341_render_glyph(attr.font, attr.fg_color, attr.bg_color, ch, spi_tx_block);
+    pixels = spi_tx_block;
+  }
+  else {
+    // the whole glyph in one transfer, the cache isn't limited to the block
+    block_wc = rect_wc;
   }
 
   // select target region
@@ -415,15 +431,53 @@ void ili9341_draw_char(ili9341_t *lcd, ili9341_text_attr_t attr, char ch)
     curr_wc = rect_wc;
     if (curr_wc > block_wc)
       { curr_wc = block_wc; }
-    ili9341_transmit_color(lcd, curr_wc * 2/*16-bit words*/, spi_tx_block, ibYes);
+    ili9341_transmit_color(lcd, curr_wc, (uint16_t *)pixels, ibYes);
     rect_wc -= curr_wc;
   }
 
   ili9341_spi_tft_release(lcd);
 }
 
+ili9341_bool_t ili9341_glyph_cache_init(ili9341_glyph_cache_t *cache,
+    ili9341_font_t const *font, ili9341_color_t fg_color, ili9341_color_t bg_color,
+    char const chars[], uint16_t pixels[], uint32_t pixels_sz/* 16-bit words */)
+{
+  if ((NULL == cache) || (NULL == font) || (NULL == chars) || (NULL == pixels))
+    { return ibFalse; }
+
+  uint32_t glyph_sz = __ILI9341_GLYPH_CACHE_WORDS(font->width, font->height, 1U);
+  if (__ILI9341_GLYPH_CACHE_WORDS(font->width, font->height, strlen(chars)) > pixels_sz)
+    { return ibFalse; }
+
+  // SRAM2 is mapped at SRAM2_BASE for the code buses of the core, the DMA
+  // reaches it through its alias right after SRAM1
+  if (((uintptr_t)pixels >= SRAM2_BASE) && ((uintptr_t)pixels < SRAM2_BASE + SRAM2_SIZE))
+    { pixels = (uint16_t *)((uintptr_t)pixels - SRAM2_BASE + SRAM1_BASE + SRAM1_SIZE_MAX); }
+
+  cache->font     = font;
+  cache->fg_color = fg_color;
+  cache->bg_color = bg_color;
+  cache->chars    = chars;
+  cache->pixels   = pixels;
+
+  for (uint32_t i = 0; '\0' != chars[i]; ++i)
+    { ili9341_render_glyph(font, fg_color, bg_color, chars[i], &(pixels[i * glyph_sz])); }
+
+  return ibTrue;
+}
+
+void ili9341_set_glyph_cache(ili9341_glyph_cache_t const *cache)
+{
+  // a single cache is consulted by ili9341_draw_char(), NULL for none
+  glyph_cache = cache;
+}
+
 void ili9341_draw_string(ili9341_t *lcd, ili9341_text_attr_t attr, char str[])
 {
+  // a single line that fits on screen goes out in one address window
+  if (ibOK(ili9341_draw_string_window(lcd, &attr, str)))
+    { return; }
+
   int16_t curr_x = attr.origin_x;
   int16_t curr_y = attr.origin_y;
   int16_t start_x = attr.origin_x;
@@ -455,8 +509,223 @@ void ili9341_draw_string(ili9341_t *lcd, ili9341_text_attr_t attr, char str[])
   }
 }
 
+void ili9341_draw_aa_string(ili9341_t *lcd, ili9341_aa_font_t const *font,
+    ili9341_color_t fg_color, ili9341_color_t bg_color,
+    int16_t x, int16_t y, char const str[])
+{
+  ili9341_aa_decoder_t decoder[__ILI9341_AA_STRING_MAX__];
+  ili9341_color_t palette[4];
+
+  uint32_t len = strlen(str);
+  uint32_t w   = len * font->width;
+
+  // both halves of the block hold a row of the whole string
+  if ( (0U == len) || (len > __ILI9341_AA_STRING_MAX__) ||
+       (2U * w > __SPI_TX_BLOCK_MAX__) || (x < 0) || (y < 0) ||
+       (x + w > lcd->screen_size.width) ||
+       (y + font->height > lcd->screen_size.height) )
+    { return; }
+
+  for (uint8_t level = 0; level < 4U; ++level)
+    { palette[level] = ili9341_blend(fg_color, bg_color, level); }
+
+  // the runs continue from one row of a glyph to the next, so each character
+  // keeps its place in them while the rows of the string are sent
+  for (uint32_t i = 0; i < len; ++i) {
+    char const *glyph = strchr(font->chars, str[i]);
+    if (NULL == glyph)
+      { glyph = font->chars; } // the first glyph is the space
+    decoder[i].run       = &(font->data[font->offset[glyph - font->chars]]);
+    decoder[i].remaining = 0U;
+  }
+
+  // select target region
+  ili9341_spi_tft_set_address_rect(lcd, x, y, x + w - 1, y + font->height - 1);
+  ili9341_spi_tft_select(lcd);
+
+  HAL_GPIO_WritePin(lcd->data_command_port, lcd->data_command_pin, __GPIO_PIN_SET__);
+
+  for (uint32_t yi = 0; yi < font->height; ++yi) {
+    uint16_t *row = &(spi_tx_block[(yi & 1) * w]);
+    for (uint32_t i = 0; i < len; ++i)
+      { ili9341_aa_decode(&(decoder[i]), palette, &(row[i * font->width]), font->width); }
+
+    ili9341_transmit_wait(lcd);
+    ili9341_transmit_color(lcd, w, row, ibNo);
+  }
+
+  ili9341_transmit_wait(lcd);
+  ili9341_spi_tft_release(lcd);
+}
+
 // ------------------------------------------------------- private functions --
 
+static ili9341_color_t ili9341_blend(ili9341_color_t fg_color,
+    ili9341_color_t bg_color, uint8_t level)
+{
+  // each of the RGB565 fields moves level/3 of the way from the background to
+  // the foreground
+  static uint16_t const mask[] = { 0xF800, 0x07E0, 0x001F };
+  ili9341_color_t color = 0U;
+
+  for (uint8_t i = 0; i < 3U; ++i) {
+    int32_t fg = fg_color & mask[i];
+    int32_t bg = bg_color & mask[i];
+    color |= (uint16_t)((bg + (fg - bg) * level / 3) & mask[i]);
+  }
+  return color;
+}
+
+static void ili9341_aa_decode(ili9341_aa_decoder_t *decoder,
+    ili9341_color_t const palette[], uint16_t pixels[], uint32_t count)
+{
+  while (count > 0U) {
+    if (0U == decoder->remaining) {
+      uint8_t run = *(decoder->run)++;
+      decoder->level     = __ILI9341_AA_RUN_LEVEL(run);
+      decoder->remaining = __ILI9341_AA_RUN_LENGTH(run);
+    }
+    uint32_t n = decoder->remaining;
+    if (n > count)
+      { n = count; }
+    ili9341_color_t color = palette[decoder->level];
+    for (uint32_t i = 0; i < n; ++i)
+      { *pixels++ = color; }
+    decoder->remaining -= n;
+    count -= n;
+  }
+}
+
+static void ili9341_draw_span(ili9341_t *lcd, ili9341_color_t color,
+    ili9341_bool_t is_steep, int16_t major0, int16_t major1, int16_t minor)
+{
+  int16_t major_size = is_steep ? lcd->screen_size.height : lcd->screen_size.width;
+  int16_t minor_size = is_steep ? lcd->screen_size.width : lcd->screen_size.height;
+
+  // the line keeps its position when it is partly off screen, only the
+  // visible part of the run is drawn
+  if ((minor < 0) || (minor >= minor_size))
+    { return; }
+  if (major0 < 0)
+    { major0 = 0; }
+  if (major1 >= major_size)
+    { major1 = major_size - 1; }
+  if (major0 > major1)
+    { return; }
+
+  if (major0 == major1) {
+    // a lone pixel, no need for the DMA transfer of ili9341_fill_rect()
+    if (is_steep)
+      { ili9341_draw_pixel(lcd, color, minor, major0); }
+    else
+      { ili9341_draw_pixel(lcd, color, major0, minor); }
+  }
+  else {
+    if (is_steep)
+      { ili9341_fill_rect(lcd, color, minor, major0, 1, major1 - major0 + 1); }
+    else
+      { ili9341_fill_rect(lcd, color, major0, minor, major1 - major0 + 1, 1); }
+  }
+}
+
+static void ili9341_render_glyph(ili9341_font_t const *font,
+    ili9341_color_t fg_color, ili9341_color_t bg_color, char ch, uint16_t pixels[])
+{
+  uint8_t ch_index = glyph_index(ch);
+  for (uint32_t yi = 0; yi < font->height; ++yi) {
+    uint32_t gl = (uint32_t)font->glyph[ch_index * font->height + yi];
+    for (uint32_t xi = 0; xi < font->width; ++xi) {
+      if ((gl << xi) & 0x8000)
+        { pixels[yi * font->width + xi] = fg_color; }
+      else
+        { pixels[yi * font->width + xi] = bg_color; }
+    }
+  }
+}
+
+static uint16_t const *ili9341_cached_glyph(ili9341_text_attr_t const *attr, char ch)
+{
+  if ( (NULL == glyph_cache) || ('\0' == ch)  ||
+       (attr->font     != glyph_cache->font)     ||
+       (attr->fg_color != glyph_cache->fg_color) ||
+       (attr->bg_color != glyph_cache->bg_color) )
+    { return NULL; }
+
+  char const *cached = strchr(glyph_cache->chars, ch);
+  if (NULL == cached)
+    { return NULL; }
+
+  uint32_t glyph_sz = __ILI9341_GLYPH_CACHE_WORDS(attr->font->width, attr->font->height, 1U);
+  return &(glyph_cache->pixels[(cached - glyph_cache->chars) * glyph_sz]);
+}
+
+static ili9341_bool_t ili9341_draw_string_window(ili9341_t *lcd,
+    ili9341_text_attr_t const *attr, char const str[])
+{
+  ili9341_font_t const *font = attr->font;
+  uint32_t len = strlen(str);
+  uint32_t w   = len * font->width;
+
+  // both halves of the block hold a row of the whole string. a single cached
+  // glyph is left to ili9341_draw_char(), which sends it straight from the
+  // cache; in a longer string its rows are copied in with the others, a
+  // window per glyph would cost more than the copy
+  if ( (0U == len) || (NULL != strpbrk(str, "\r\n")) ||
+       ((1U == len) && (NULL != ili9341_cached_glyph(attr, str[0]))) ||
+       (2U * w > __SPI_TX_BLOCK_MAX__) ||
+       ((int16_t)attr->origin_x < 0) || ((int16_t)attr->origin_y < 0) ||
+       (attr->origin_x + w > lcd->screen_size.width) ||
+       (attr->origin_y + font->height > lcd->screen_size.height) )
+    { return ibFalse; }
+
+  // select target region
+  ili9341_spi_tft_set_address_rect(lcd,
+      attr->origin_x, attr->origin_y,
+      attr->origin_x + w - 1, attr->origin_y + font->height - 1);
+  ili9341_spi_tft_select(lcd);
+
+  HAL_GPIO_WritePin(lcd->data_command_port, lcd->data_command_pin, __GPIO_PIN_SET__);
+
+  // each row is rendered into one half of the block while the previous row is
+  // transmitted from the other half
+  for (uint32_t yi = 0; yi < font->height; ++yi) {
+    uint16_t *row = &(spi_tx_block[(yi & 1) * w]);
+    for (uint32_t i = 0; i < len; ++i) {
+      uint16_t *cell = &(row[i * font->width]);
+      uint16_t const *cached = ili9341_cached_glyph(attr, str[i]);
+      if (NULL != cached) {
+        memcpy(cell, &(cached[yi * font->width]), font->width * sizeof(uint16_t));
+        continue;
+      }
+      uint32_t gl = (uint32_t)font->glyph[glyph_index(str[i]) * font->height + yi];
+      for (uint32_t xi = 0; xi < font->width; ++xi) {
+        if ((gl << xi) & 0x8000)
+          { cell[xi] = attr->fg_color; }
+        else
+          { cell[xi] = attr->bg_color; }
+      }
+    }
+
+    ili9341_transmit_wait(lcd);
+    ili9341_transmit_color(lcd, w, row, ibNo);
+  }
+
+  ili9341_transmit_wait(lcd);
+  ili9341_spi_tft_release(lcd);
+
+  return ibTrue;
+}
+
+static void ili9341_transmit_fill_next(ili9341_t *lcd)
+{
+  uint32_t count = lcd->fill_remaining;
+  if (count > __SPI_TX_FILL_MAX__)
+    { count = __SPI_TX_FILL_MAX__; }
+
+  lcd->fill_remaining -= count;
+  HAL_SPI_Transmit_DMA(lcd->spi_hal, (uint8_t *)&(lcd->fill_color), count);
+}
+
 static ili9341_bool_t ili9341_clip_rect(ili9341_t *lcd,
     int16_t *x, int16_t *y, uint16_t *w, uint16_t *h)
 {
@@ -0,0 +1,74 @@
+/*
+ * ili9341_ll.c
+ *
+ * Register level SPI access to the ILI9341: the commands and the address
+ * window. The address window is cached, so that CASET and PASET are only sent
+ * when they change.
+ *
+ * The bytes are moved by the bus back-end, ili9341_ll_spi.c on the target. The
+ * host tools replace only that one, this part is the same on both.
+ */
+
+// ----------------------------------------------------------------- includes --
+
+#include "ili9341_ll.h"
+
+// ---------------------------------------------------------- private defines --
+
+/* nothing */
+
+// ----------------------------------------------------------- private macros --
+
+#define __WINDOW_NONE 0xFFFFU // never a valid address, forces the next update
+
+// ------------------------------------------------------- exported functions --
+
+void ili9341_ll_write_command(ili9341_t *lcd, uint8_t command)
+{
+  ili9341_ll_transmit(lcd, __GPIO_PIN_CLR__, 1U, &command);
+}
+
+void ili9341_ll_write_data(ili9341_t *lcd, uint16_t data_sz, uint8_t const data[])
+{
+  ili9341_ll_transmit(lcd, __GPIO_PIN_SET__, data_sz, data);
+}
+
+void ili9341_ll_write_command_data(ili9341_t *lcd,
+    uint8_t command, uint16_t data_sz, uint8_t const data[])
+{
+  ili9341_ll_write_command(lcd, command);
+  ili9341_ll_write_data(lcd, data_sz, data);
+}
+
+void ili9341_ll_set_window(ili9341_t *lcd,
+    uint16_t x0, uint16_t y0, uint16_t x1, uint16_t y1)
+{
+  // RAMWR restarts the memory pointer from the window origin, so the column
+  // and page ranges only have to be sent when they differ from the last ones.
+  // a column of pixels keeps its column range, a row its page range.
+  if ((x0 != lcd->window_x0) || (x1 != lcd->window_x1)) {
+    ili9341_ll_write_command_data(lcd, __ILI9341_CMD_CASET__, 4,
+        (uint8_t[]){ __MSBYTEu16(x0), __LSBYTEu16(x0), __MSBYTEu16(x1), __LSBYTEu16(x1) });
+    lcd->window_x0 = x0;
+    lcd->window_x1 = x1;
+  }
+
+  if ((y0 != lcd->window_y0) || (y1 != lcd->window_y1)) {
+    ili9341_ll_write_command_data(lcd, __ILI9341_CMD_PASET__, 4,
+        (uint8_t[]){ __MSBYTEu16(y0), __LSBYTEu16(y0), __MSBYTEu16(y1), __LSBYTEu16(y1) });
+    lcd->window_y0 = y0;
+    lcd->window_y1 = y1;
+  }
+
+  ili9341_ll_write_command(lcd, __ILI9341_CMD_RAMWR__);
+}
+
+void ili9341_ll_invalidate_window(ili9341_t *lcd)
+{
+  // the window registers are unknown after a reset, and a change of the
+  // memory access control (MADCTL) swaps their meaning
+  lcd->window_x0 = __WINDOW_NONE;
+  lcd->window_x1 = __WINDOW_NONE;
+  lcd->window_y0 = __WINDOW_NONE;
+  lcd->window_y1 = __WINDOW_NONE;
+}
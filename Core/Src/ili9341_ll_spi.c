@@ -0,0 +1,126 @@
+/*
+ * ili9341_ll_spi.c
+ *
+ * SPI back-end of ili9341_ll.c on the target.
+ *
+ * HAL_SPI_Transmit() costs several microseconds of state handling, locking
+ * and timeout bookkeeping per call, which is more than the transfer itself
+ * for the 1 to 4 byte commands and parameters of the address window. These
+ * functions write the bytes straight into the data register instead, keeping
+ * the TX FIFO fed, and only wait for the bus to go idle where D/C or CS may
+ * change next.
+ */
+
+// ----------------------------------------------------------------- includes --
+
+#include "ili9341_ll.h"
+
+// ---------------------------------------------------------- private defines --
+
+/* nothing */
+
+// ----------------------------------------------------------- private macros --
+
+// D/C and CS are driven through the bit set/reset register, the HAL GPIO
+// function does the same with a call and an assert on top
+#define __PIN_SET(port, pin) ((port)->BSRR = (uint32_t)(pin))
+#define __PIN_CLR(port, pin) ((port)->BRR  = (uint32_t)(pin))
+
+// ------------------------------------------------------ function prototypes --
+
+static void ili9341_ll_wait_idle(SPI_TypeDef *spi);
+
+// ------------------------------------------------------- exported functions --
+
+void ili9341_ll_transmit(ili9341_t *lcd,
+    GPIO_PinState data_command, uint16_t data_sz, uint8_t const data[])
+{
+  SPI_TypeDef *spi = lcd->spi_hal->Instance;
+
+  // a DMA transfer (or fill) started without waiting may still be running, and
+  // when the DMA is done its last frames are still in the FIFO and the shifter.
+  // D/C may only change once they are out, or the panel takes them for commands
+  while ((lcd->fill_remaining > 0U) ||
+         (HAL_DMA_STATE_BUSY == HAL_DMA_GetState(lcd->spi_hal->hdmatx)))
+    { continue; }
+  ili9341_ll_wait_idle(spi);
+
+  if (__GPIO_PIN_SET__ == data_command)
+    { __PIN_SET(lcd->data_command_port, lcd->data_command_pin); }
+  else
+    { __PIN_CLR(lcd->data_command_port, lcd->data_command_pin); }
+
+  ili9341_ll_set_frame_size(lcd, SPI_DATASIZE_8BIT);
+
+  if (0U == (spi->CR1 & SPI_CR1_SPE))
+    { spi->CR1 |= SPI_CR1_SPE; }
+
+  // 8-bit frames, so the data register has to be written with byte accesses,
+  // a 16-bit write would queue two frames
+  while (data_sz-- > 0U) {
+    while (0U == (spi->SR & SPI_SR_TXE))
+      { continue; }
+    *(__IO uint8_t *)&spi->DR = *data++;
+  }
+
+  ili9341_ll_wait_idle(spi);
+}
+
+void ili9341_ll_set_frame_size(ili9341_t *lcd, uint32_t data_size)
+{
+  SPI_HandleTypeDef *spi_hal = lcd->spi_hal;
+
+  if (data_size == spi_hal->Init.DataSize)
+    { return; }
+
+  while ((lcd->fill_remaining > 0U) ||
+         (HAL_DMA_STATE_BUSY == HAL_DMA_GetState(spi_hal->hdmatx)))
+    { continue; }
+  ili9341_ll_wait_idle(spi_hal->Instance);
+
+  // DS is changed with the peripheral disabled, the next transfer (HAL or
+  // ili9341_ll_transmit()) enables it again. the HAL reads the frame size
+  // from the handle, to count the transfer in bytes or in 16-bit words.
+  CLEAR_BIT(spi_hal->Instance->CR1, SPI_CR1_SPE);
+  MODIFY_REG(spi_hal->Instance->CR2, SPI_CR2_DS | SPI_CR2_FRXTH,
+      data_size | ((SPI_DATASIZE_8BIT == data_size) ? SPI_RXFIFO_THRESHOLD_QF : 0U));
+  spi_hal->Init.DataSize = data_size;
+}
+
+void ili9341_ll_set_dma_source(ili9341_t *lcd, ili9341_bool_t increment)
+{
+  DMA_HandleTypeDef *dma = lcd->spi_hal->hdmatx;
+  uint32_t mem_inc = ibOK(increment) ? DMA_MINC_ENABLE : DMA_MINC_DISABLE;
+
+  if ((mem_inc == dma->Init.MemInc) &&
+      (DMA_MDATAALIGN_HALFWORD == dma->Init.MemDataAlignment))
+    { return; }
+
+  // the channel can only be reconfigured while it is disabled
+  while (HAL_DMA_STATE_BUSY == HAL_DMA_GetState(dma))
+    { continue; }
+
+  // the handle is kept in sync with the CCR, HAL_SPI_Transmit_DMA() reads it
+  dma->Init.MemInc              = mem_inc;
+  dma->Init.PeriphDataAlignment = DMA_PDATAALIGN_HALFWORD;
+  dma->Init.MemDataAlignment    = DMA_MDATAALIGN_HALFWORD;
+  MODIFY_REG(dma->Instance->CCR, DMA_CCR_MINC | DMA_CCR_PSIZE | DMA_CCR_MSIZE,
+      mem_inc | DMA_PDATAALIGN_HALFWORD | DMA_MDATAALIGN_HALFWORD);
+}
+
+// ------------------------------------------------------- private functions --
+
+static void ili9341_ll_wait_idle(SPI_TypeDef *spi)
+{
+  // wait for the TX FIFO to drain and the last frame to leave the shifter
+  while (0U != (spi->SR & SPI_SR_FTLVL))
+    { continue; }
+  while (0U != (spi->SR & SPI_SR_BSY))
+    { continue; }
+
+  // the bus is full duplex, discard what was received meanwhile and clear the
+  // overrun, so that the next (HAL) receive starts clean
+  while (0U != (spi->SR & SPI_SR_FRLVL))
+    { (void)*(__IO uint8_t *)&spi->DR; }
+  (void)spi->SR;
+}
@@ -0,0 +1,158 @@
+#include "stm32l4xx_hal.h"
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+#include "mains_canceller.h"
+#include "signal_processing.h"
+
+/*
+    Adaptive canceller of the mains interference. Unlike a notch filter it only removes the sinusoid actually
+    present at the mains frequency, so the QRS complexes keep their shape.
+
+    The interference is modeled as a weighted sum of a sine and a cosine reference at the mains frequency, and the
+    weights follow it with the LMS algorithm: w += 2 mu e r, where e is the input minus the estimate. The step size
+    mu = 2^-7 gives a time constant of about 128 samples and an effective notch width well below 1 Hz.
+    The weights are updated from the input minus its average over MAINS_PHASE_PERIOD, which contains whole periods
+    of both frequencies, so the baseline of the signal (thousands of ADC counts) doesn't shake them.
+    The mains frequency is detected first, by correlating the input with both frequencies over DETECTION_SAMPLES. The
+    canceller passes the input unchanged meanwhile, and keeps detecting while no interference is found. The
+    correlation at the detected frequency is the interference itself, the weights start from it rather than from 0,
+    so there is no convergence transient for the detector to see.
+    The estimate is only subtracted while the interference is at least CANCEL_AMPLITUDE. The low pass filter of the
+    detector already attenuates the mains by 25 dB (50 Hz) and 37 dB (60 Hz). Below that amplitude, taking the hum
+    out moves the threshold crossings of marginal beats as much as leaving it in does, the estimate itself jumps by a
+    few counts with every QRS complex. The weights follow the interference either way.
+*/
+
+#define DETECTION_SAMPLES 400 // Whole periods of both frequencies, 2 seconds.
+
+#define MIN_AMPLITUDE 2.0f // Interference below this amplitude (ADC counts) is not tracked.
+
+#define CANCEL_AMPLITUDE 24.0f // The estimate is subtracted from this amplitude (ADC counts) on, and down to half of it
+                               // once it is, so the QRS complexes moving the estimate don't toggle it.
+
+#define STEP_SHIFT 5 // The weight update e * r (Q15) is shifted into Q16 by this much, mu = 2^-(STEP_SHIFT + 2).
+
+#define GRADIENT_SHIFT 8 // Smoothing of the gradient, over about 256 samples, longer than a heart beat.
+
+#define CONVERGED_RATIO 0.1f // Converged when the residual interference is below this part of the cancelled one.
+
+static const uint8_t FREQUENCIES[MAINS_FREQUENCY_COUNT] = { 50, 60 };
+
+static const uint8_t PERIODS[MAINS_FREQUENCY_COUNT] = { 4, 10 };
+
+// One period of the references in Q15, sin(2 pi f n / SAMPLING_FREQUENCY) and cos(2 pi f n / SAMPLING_FREQUENCY).
+static const int16_t SIN_50[4] = { 0, 32767, 0, -32767 };
+static const int16_t COS_50[4] = { 32767, 0, -32767, 0 };
+static const int16_t SIN_60[10] = { 0, 31163, -19260, -19260, 31163, 0, -31163, 19260, 19260, -31163 };
+static const int16_t COS_60[10] = { 32767, -10126, -26509, 26509, 10126, -32767, 10126, 26509, -26509, -10126 };
+
+static const int16_t* const SIN_TABLES[MAINS_FREQUENCY_COUNT] = { SIN_50, SIN_60 };
+static const int16_t* const COS_TABLES[MAINS_FREQUENCY_COUNT] = { COS_50, COS_60 };
+
+void reset_mains_canceller(pt_mains_canceller_t* canceller) {
+  memset(canceller, 0, sizeof(pt_mains_canceller_t));
+}
+
+// Amplitude of the component of a correlation window at one of the frequencies, in ADC counts.
+static float detected_amplitude(const pt_mains_canceller_t* canceller, uint8_t f) {
+  float s = canceller->detection_sin[f], c = canceller->detection_cos[f];
+  return 2 * sqrtf(s * s + c * c) / (DETECTION_SAMPLES * 32767.0f);
+}
+
+static void detect_frequency(pt_mains_canceller_t* canceller, uint16_t sample) {
+  for (uint8_t f = 0; f < MAINS_FREQUENCY_COUNT; f++) {
+    uint8_t n = canceller->phase % PERIODS[f];
+    canceller->detection_sin[f] += (int32_t) sample * SIN_TABLES[f][n];
+    canceller->detection_cos[f] += (int32_t) sample * COS_TABLES[f][n];
+  }
+  if (++canceller->detection_count < DETECTION_SAMPLES) {
+    return;
+  }
+  float amplitude_50 = detected_amplitude(canceller, 0), amplitude_60 = detected_amplitude(canceller, 1);
+  if (amplitude_50 >= MIN_AMPLITUDE || amplitude_60 >= MIN_AMPLITUDE) {
+    uint8_t f = amplitude_50 >= amplitude_60 ? 0 : 1;
+    canceller->frequency = FREQUENCIES[f];
+    // The correlations with the Q15 references over the window, scaled to the Q16 weights: 2 / DETECTION_SAMPLES
+    // times 2^16 / 2^15.
+    canceller->weight_sin = canceller->detection_sin[f] * 4 / DETECTION_SAMPLES;
+    canceller->weight_cos = canceller->detection_cos[f] * 4 / DETECTION_SAMPLES;
+  }
+  canceller->detection_count = 0;
+  memset(canceller->detection_sin, 0, sizeof(canceller->detection_sin));
+  memset(canceller->detection_cos, 0, sizeof(canceller->detection_cos));
+}
+
+// Opens and closes the gate of the estimate, once per common period, on the amplitude of the weights.
+static void update_cancelling(pt_mains_canceller_t* canceller) {
+  int64_t weight_sin = canceller->weight_sin, weight_cos = canceller->weight_cos;
+  int64_t squared = weight_sin * weight_sin + weight_cos * weight_cos;
+  float limit = (canceller->cancelling ? CANCEL_AMPLITUDE / 2 : CANCEL_AMPLITUDE) * 65536.0f;
+  canceller->cancelling = canceller->frequency != 0 && squared >= (int64_t) (limit * limit);
+}
+
+/*
+    Cancels the mains interference from the next sample of the lead. adapt is false while the input is saturated,
+    the weights are kept then.
+*/
+uint16_t cancel_mains(pt_mains_canceller_t* canceller, uint16_t sample, bool adapt) {
+  uint16_t output = sample;
+
+  canceller->history_sum += sample - canceller->history[canceller->phase];
+  canceller->history[canceller->phase] = sample;
+
+  if (canceller->frequency == 0) {
+    detect_frequency(canceller, sample);
+  }
+  else {
+    uint8_t f = canceller->frequency == FREQUENCIES[0] ? 0 : 1;
+    uint8_t n = canceller->phase % PERIODS[f];
+    int32_t reference_sin = SIN_TABLES[f][n], reference_cos = COS_TABLES[f][n];
+
+    // Q16 weights times Q15 references, rounded to ADC counts.
+    int32_t estimate = ((int64_t) canceller->weight_sin * reference_sin + (int64_t) canceller->weight_cos * reference_cos +
+        (1 << 30)) >> 31;
+    int32_t error = sample - estimate;
+
+    if (adapt) {
+      int32_t residual = error - (int32_t) (canceller->history_sum / MAINS_PHASE_PERIOD);
+      int32_t correlation_sin = residual * reference_sin, correlation_cos = residual * reference_cos;
+      canceller->weight_sin += correlation_sin >> STEP_SHIFT;
+      canceller->weight_cos += correlation_cos >> STEP_SHIFT;
+      canceller->gradient_sin += ((correlation_sin >> 7) - canceller->gradient_sin) >> GRADIENT_SHIFT;
+      canceller->gradient_cos += ((correlation_cos >> 7) - canceller->gradient_cos) >> GRADIENT_SHIFT;
+    }
+
+    if (!canceller->cancelling) {
+      output = sample;
+    }
+    else if (error < 0) {
+      output = 0;
+    }
+    else if (error > ADC_MAX_VALUE) {
+      output = ADC_MAX_VALUE;
+    }
+    else {
+      output = error;
+    }
+  }
+
+  if (++canceller->phase == MAINS_PHASE_PERIOD) {
+    canceller->phase = 0;
+    update_cancelling(canceller);
+  }
+  return output;
+}
+
+void get_mains_metrics(const pt_mains_canceller_t* canceller, pt_mains_metrics_t* metrics) {
+  float weight_sin = canceller->weight_sin / 65536.0f, weight_cos = canceller->weight_cos / 65536.0f;
+  // The smoothed correlation of the output with a unit reference is half the amplitude of the residual.
+  float gradient_sin = canceller->gradient_sin / 256.0f, gradient_cos = canceller->gradient_cos / 256.0f;
+  float residual_amplitude = 2 * sqrtf(gradient_sin * gradient_sin + gradient_cos * gradient_cos);
+
+  metrics->frequency = canceller->frequency;
+  metrics->amplitude = sqrtf(weight_sin * weight_sin + weight_cos * weight_cos);
+  metrics->residual_power = residual_amplitude * residual_amplitude / 2;
+  metrics->converged = canceller->frequency != 0 && residual_amplitude < CONVERGED_RATIO * metrics->amplitude + 0.5f;
+  metrics->cancelling = canceller->cancelling;
+}
@@ -0,0 +1,64 @@
+#include "stm32l4xx_hal.h"
+#include <stdbool.h>
+#include "pt_filters.h"
+
+/*
+    Integer band-pass filter of the Pan-Tompkins detector: DC block, low pass and high pass.
+
+    The low pass and the high pass filters have integer coefficients, so they are computed exactly in 32 bit
+    integers. The filters are scalar, one lead at a time. The packed 16 bit instructions don't pay off here: only
+    the input difference of the DC block and x(nT) - 2x(nT - 6T) + x(nT - 12T) of the low pass filter fit in 16 bit
+    lanes, and packing and unpacking them for two leads takes more instructions than it saves. The low pass output
+    grows to 36 times the DC blocked signal, so the recursive parts and the high pass filter need 32 bits, and their
+    non-recursive form (a 43 tap FIR on the DC blocked signal) would take more SMLADs than the recursions take
+    instructions.
+*/
+
+#define RING(x) (((x) + BUFFER_SIZE) % BUFFER_SIZE)
+
+#define DC_POLE 32604 // Pole of the DC block, 0.995 in Q15.
+
+static inline int16_t clamp_dcblock(int32_t value) {
+  if (value > PT_DCBLOCK_LIMIT) {
+    return PT_DCBLOCK_LIMIT;
+  }
+  if (value < -PT_DCBLOCK_LIMIT) {
+    return -PT_DCBLOCK_LIMIT;
+  }
+  return value;
+}
+
+// The feedback of the DC block. Divided rather than shifted, so it rounds toward zero and the filter decays to 0
+// instead of settling at -1 on a flat input.
+static inline int32_t dc_decay(int16_t previous) {
+  return DC_POLE * previous / 32768;
+}
+
+// The recursive part of the low pass filter and the high pass filter, fir is the non-recursive part of the low pass.
+static inline void filter_recursive(const pt_filter_lane_t* lane, int32_t n, int32_t fir) {
+  // Low Pass filter
+  // y(nT) = 2y(nT - T) - y(nT - 2T) + x(nT) - 2x(nT - 6T) + x(nT - 12T)
+  lane->lowpass[n] = 2 * lane->lowpass[RING(n - 1)] - lane->lowpass[RING(n - 2)] + fir;
+
+  // High Pass filter
+  // y(nT) = 32x(nT - 16T) - [y(nT - T) + x(nT) - x(nT - 32T)]
+  lane->highpass[n] = 32 * lane->lowpass[RING(n - 16)] - lane->highpass[RING(n - 1)] - lane->lowpass[n] +
+      lane->lowpass[RING(n - 32)];
+}
+
+void pt_filter(const pt_filter_lane_t* lane, uint32_t array_index, bool restart) {
+  int32_t n = array_index;
+
+  // DC Block filter
+  // y(nT) = x(nT) - x(nT - T) + 0.995y(nT - T)
+  if (restart) {
+    lane->dcblock[n] = 0;
+  }
+  else {
+    lane->dcblock[n] = clamp_dcblock(lane->signal[n] - lane->signal[RING(n - 1)] +
+        dc_decay(lane->dcblock[RING(n - 1)]));
+  }
+
+  filter_recursive(lane, n,
+      lane->dcblock[n] - 2 * lane->dcblock[RING(n - 6)] + lane->dcblock[RING(n - 12)]);
+}
@@ -0,0 +1,96 @@
+#include "stm32l4xx_hal.h"
+#include <string.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "settings.h"
+
+// The settings live in the last flash page, which the linker script keeps out of the FLASH region.
+// The record is written from its start and validated with a magic number, a version and a CRC, so an erased page,
+// a record of an older firmware or a write interrupted by the power going down is simply ignored.
+
+#define SETTINGS_MAGIC 0x454B4731 // "EKG1"
+
+#define SETTINGS_VERSION 2 // 2: the peak estimates are in 14 bit ADC units, the oversampled front-end
+
+typedef struct {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t size;
+  pt_state_t detector;
+  uint32_t crc;
+} settings_record_t;
+
+// Flash is programmed in double words, so the record is padded to a multiple of 8 bytes.
+typedef union {
+  settings_record_t record;
+  uint64_t double_words[(sizeof(settings_record_t) + 7) / 8];
+} settings_page_t;
+
+extern uint32_t _settings_start;
+
+CRC_HandleTypeDef* crc_hal;
+
+void settings_init(CRC_HandleTypeDef* crc) {
+  crc_hal = crc;
+}
+
+static uint32_t record_crc(const settings_record_t* record) {
+  return HAL_CRC_Calculate(crc_hal, (uint32_t*) record, offsetof(settings_record_t, crc));
+}
+
+static bool is_valid_record(const settings_record_t* record) {
+  return record->magic == SETTINGS_MAGIC &&
+      record->version == SETTINGS_VERSION &&
+      record->size == sizeof(settings_record_t) &&
+      record->crc == record_crc(record);
+}
+
+/*
+    Reads the detector state saved by the previous session. Returns false if there is no valid record; whether the
+    state itself is still usable is up to the detector to decide.
+*/
+bool settings_load_detector_state(pt_state_t* state) {
+  const settings_record_t* stored = (const settings_record_t*) &_settings_start;
+  if (!is_valid_record(stored)) {
+    return false;
+  }
+  *state = stored->detector;
+  return true;
+}
+
+/*
+    Saves the detector state to the settings page. The page is only erased and written when the content changes,
+    to spare the flash. Returns false if the flash couldn't be written.
+    The erase stalls the flash for milliseconds, so this is called from the main loop, not from an interrupt.
+*/
+bool settings_save_detector_state(const pt_state_t* state) {
+  settings_page_t page;
+  memset(&page, 0, sizeof(page));
+  page.record.magic = SETTINGS_MAGIC;
+  page.record.version = SETTINGS_VERSION;
+  page.record.size = sizeof(settings_record_t);
+  page.record.detector = *state;
+  page.record.crc = record_crc(&page.record);
+
+  uint32_t address = (uint32_t) &_settings_start;
+  if (memcmp((const void*) address, &page, sizeof(page)) == 0) {
+    return true;
+  }
+
+  FLASH_EraseInitTypeDef erase;
+  erase.TypeErase = FLASH_TYPEERASE_PAGES;
+  erase.Banks = FLASH_BANK_1;
+  erase.Page = (address - FLASH_BASE) / FLASH_PAGE_SIZE;
+  erase.NbPages = 1;
+  uint32_t page_error;
+
+  HAL_FLASH_Unlock();
+  // Error flags left over from before (OPTVERR and PGSERR are often set out of reset) would fail the erase.
+  __HAL_FLASH_CLEAR_FLAG(FLASH_FLAG_ALL_ERRORS);
+  bool saved = HAL_FLASHEx_Erase(&erase, &page_error) == HAL_OK;
+  for (uint8_t i = 0; saved && i < sizeof(page.double_words) / sizeof(uint64_t); i++) {
+    saved = HAL_FLASH_Program(FLASH_TYPEPROGRAM_DOUBLEWORD, address + i * sizeof(uint64_t), page.double_words[i]) == HAL_OK;
+  }
+  HAL_FLASH_Lock();
+  return saved;
+}
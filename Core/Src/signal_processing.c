@@ -1,6 +1,9 @@
 #include "stm32l4xx_hal.h"
 #include <stdbool.h>
+#include <string.h>
+#include <math.h>
 #include "signal_processing.h"
+#include "pt_filters.h"
 
 /**
  * ------------------------------------------------------------------------------*
@@ -165,69 +168,446 @@
 
 #define DELAY_2s_IN_SAMPLES 400
 
-#define MAX_RR_AVERAGE_INDEX 7
-
-#define RR_INTERVALS_TO_SKIP 7
-
-// The signal array is where the most recent samples are kept. The other arrays are the outputs of each
-// filtering module: DC Block, low pass, high pass, integral etc.
-int16_t dcblock[BUFFER_SIZE] = {0};
-float lowpass[BUFFER_SIZE] = {0},
-  highpass[BUFFER_SIZE] = {0},
-  derivative[BUFFER_SIZE] = {0},
-  squared_derivative[BUFFER_SIZE] = {0},
-  integral[BUFFER_SIZE] = {0};
-
-// i, j and k are iterators for loops.
-// sample counts how many samples have been read so far.
-// lastQRS stores which was the last sample read when the last R sample was triggered.
-// lastSlope stores the value of the squared slope when the last R sample was triggered.
-// currentSlope helps calculate the max. square slope for the present sample.
-// These are all long unsigned int so that very long signals can be read without messing the count.
-int32_t i, j, k;
-
-int32_t sample = 0, lastQRS = 0;
-
-float lastSlope = 0, currentSlope = 0;
-
-// rr1 holds the last MAX_RR_AVERAGE_INDEX + 1 RR intervals. rr2 holds the last MAX_RR_AVERAGE_INDEX + 1 RR intervals between rrlow and rrhigh.
-// rravg1 is the rr1 average, rr2 is the rravg2. rrlow = 0.92*rravg2, rrhigh = 1.08*rravg2 and rrmiss = 1.16*rravg2.
-// rrlow is the lowest RR-interval considered normal for the current_index heart beat, while rrhigh is the highest.
-// rrmiss is the longest that it would be expected until a new QRS is detected. If none is detected for such
-// a long interval, the thresholds must be adjusted.
-uint16_t rr1[MAX_RR_AVERAGE_INDEX + 1], rr2[MAX_RR_AVERAGE_INDEX + 1], rravg1, rravg2, rrlow = 100, rrhigh = 200, rrmiss = 0, max_index;
-
-uint16_t rr_count = 0, last_rr_average_index = 0;
-
-// There are the variables from the original Pan-Tompkins algorithm.
-// The ones ending in _i correspond to values from the integrator.
-// The ones ending in _f correspond to values from the DC-block/low-pass/high-pass filtered signal.
-// The peak variables are peak candidates: signal values above the thresholds.
-// The threshold 1 variables are the threshold variables. If a signal sample is higher than this threshold, it's a peak.
-// The threshold 2 variables are half the threshold 1 ones. They're used for a back search when no peak is detected for too long.
-// The spk and npk variables are, respectively, running estimates of signal and noise peaks.
-float peak_i = 0,
-    peak_f = 0,
-    threshold_i1 = 0,
-    threshold_i2 = 0,
-    threshold_f1 = 0,
-    threshold_f2 = 0,
-    signalpeak_i = 0,
-    signalpeak_f = 0,
-    noisepeak_i = 0,
-    noisepeak_f = 0;
-
-// regular tells whether the heart pace is regular or not.
-// prevRegular tells whether the heart beat was regular before the newest RR-interval was calculated.
-bool regular = true, prevRegular;
+#define RR_INTERVALS_TO_SKIP 0
+
+#define LEARNING_SAMPLES 400 // DELAY_2s_IN_SAMPLES, as proposed by the original paper.
+
+#define FILTER_SETTLE_SAMPLES 50 // The high pass filter and the integrator need ~250ms to fill their windows.
+
+#define FAST_RESTORE_SAMPLES 40 // 200ms, the low and high pass filters settle in 43 samples from a cleared history.
+
+#define FUSION_WINDOW_SAMPLES 15 // 75ms, detections of the same beat on different leads are at most this far apart.
+
+#define BANDPASS_DELAY_SAMPLES 21 // Group delay of the low pass (5 samples) and the high pass (16 samples) filters.
+
+#define R_PEAK_SEARCH_RADIUS 5 // 25ms, the R peak is looked for this far around its position estimated by the filters.
+
+#if TEMPLATE_LENGTH - TEMPLATE_BEFORE_R - 1 + TEMPLATE_MAX_SHIFT > BANDPASS_DELAY_SAMPLES - R_PEAK_SEARCH_RADIUS
+#error "The template has to end within the DC blocked signal available at the detection"
+#endif
+
+#define MIN_LEARNING_RR 60 // 300ms, 200 BPM
+
+#define MAX_LEARNING_RR 400 // 2s, 30 BPM
+
+#define PT_DEFAULT_PARAMS_INITIALIZER { \
+  .peak_weight = 0.125f, \
+  .threshold_fraction = 0.25f, \
+  .window_size = WINDOW_SIZE, \
+  .rr_low_limit = 0.92f, \
+  .rr_high_limit = 1.16f, \
+  .rr_miss_limit = 1.66f, \
+  .rr_intervals_to_skip = RR_INTERVALS_TO_SKIP, \
+  .learning_samples = LEARNING_SAMPLES \
+}
+
+const pt_params_t PT_DEFAULT_PARAMS = PT_DEFAULT_PARAMS_INITIALIZER;
+
+// The parameters currently used by the detector.
+pt_params_t params = PT_DEFAULT_PARAMS_INITIALIZER;
+
+// The state of a detector is kept in a pt_detector_t, one per lead, see signal_processing.h.
+
+/*
+    Replaces the tunable parameters of the detector. The window size is limited to the buffer size, as the
+    integrator reads its window back from the squared derivative buffer, and the learning phase can't be empty.
+*/
+void set_pan_tompkins_params(const pt_params_t* new_params) {
+  params = *new_params;
+  if (params.window_size < 1) {
+    params.window_size = 1;
+  }
+  else if (params.window_size > BUFFER_SIZE) {
+    params.window_size = BUFFER_SIZE;
+  }
+  if (params.learning_samples < 1) {
+    params.learning_samples = 1;
+  }
+}
+
+/*
+    Clears the histories of the filters. As the DC block removes the level of the input, all-zero histories are the
+    settled state of the filters for any constant input.
+*/
+static void clear_filters(pt_detector_t* detector) {
+  memset(detector->dcblock, 0, sizeof(detector->dcblock));
+  memset(detector->lowpass, 0, sizeof(detector->lowpass));
+  memset(detector->highpass, 0, sizeof(detector->highpass));
+  memset(detector->derivative, 0, sizeof(detector->derivative));
+  memset(detector->squared_derivative, 0, sizeof(detector->squared_derivative));
+  memset(detector->integral, 0, sizeof(detector->integral));
+}
+
+/*
+    Brings the detector to its initial state, so that a new, unrelated signal can be processed starting from index 0.
+    A detector has to be reset before its first sample.
+*/
+void reset_pan_tompkins(pt_detector_t* detector) {
+  clear_filters(detector);
+  reset_mains_canceller(&detector->mains);
+  reset_beat_template(&detector->beat_template);
+  memset(detector->rr1, 0, sizeof(detector->rr1));
+  memset(detector->rr2, 0, sizeof(detector->rr2));
+
+  detector->sample = 0;
+  detector->lastQRS = 0;
+  detector->lastSlope = 0;
+  detector->currentSlope = 0;
+  detector->last_r_peak_q8 = 0;
+  detector->has_r_peak = false;
+  detector->rejected_until = 0;
+  detector->rravg1 = 0;
+  detector->rravg2 = 0;
+  detector->rrlow = 100;
+  detector->rrhigh = 200;
+  detector->rrmiss = 0;
+  detector->rr_count = 0;
+  detector->last_rr_average_index = 0;
+  detector->peak_i = 0;
+  detector->peak_f = 0;
+  detector->threshold_i1 = 0;
+  detector->threshold_i2 = 0;
+  detector->threshold_f1 = 0;
+  detector->threshold_f2 = 0;
+  detector->signalpeak_i = 0;
+  detector->signalpeak_f = 0;
+  detector->noisepeak_i = 0;
+  detector->noisepeak_f = 0;
+  detector->regular = true;
+  detector->prevRegular = true;
+  detector->learning_count = 0;
+  detector->learning_max_i = 0;
+  detector->learning_max_f = 0;
+  detector->learning_sum_i = 0;
+  detector->learning_sum_f = 0;
+  detector->rr_seeded = false;
+  detector->thresholds_known = false;
+  detector->restore_count = 0;
+  detector->saturated = false;
+}
+
+// Starts learning phase 1 over, from the settling of the filters.
+static void restart_learning(pt_detector_t* detector) {
+  detector->learning_count = 0;
+  detector->learning_max_i = 0;
+  detector->learning_max_f = 0;
+  detector->learning_sum_i = 0;
+  detector->learning_sum_f = 0;
+}
+
+/*
+    Continues an interrupted signal (e.g. after a lead-off): the filter histories are cleared, so the detector
+    doesn't have to chew through the saturated samples, but the adapted thresholds, the RR averages and the mains
+    canceller are kept. The beat template is dropped, the electrodes may have moved and changed the shape of the
+    beats.
+    The first beat after the restart only marks the start of the next RR interval.
+*/
+void restart_pan_tompkins(pt_detector_t* detector) {
+  clear_filters(detector);
+  reset_beat_template(&detector->beat_template);
+
+  detector->lastSlope = 0;
+  detector->currentSlope = 0;
+  detector->has_r_peak = false;
+  detector->rejected_until = 0;
+  detector->rr_count = 0;
+  detector->peak_i = 0;
+  detector->peak_f = 0;
+  detector->thresholds_known = detector->thresholds_known || detector->learning_count >= FILTER_SETTLE_SAMPLES + params.learning_samples;
+  restart_learning(detector);
+  detector->restore_count = 0;
+  detector->saturated = false;
+}
+
+/*
+    Fast restore. A saturated sample (an electrode bump or motion drove the front-end into the rail) clears the
+    filter histories on its first occurrence, so the filters don't ring for seconds after the jump. The DC block
+    restarts from the current input level while the input is saturated and on the first sample after that. For
+    FAST_RESTORE_SAMPLES after the saturation no peaks are detected, so the thresholds aren't updated from the
+    transient, and the next beat only starts a new RR interval.
+    Returns true if the DC block has to restart from the current input.
+*/
+static bool fast_restore(pt_detector_t* detector, uint16_t value) {
+  bool was_saturated = detector->saturated;
+  detector->saturated = value <= ADC_SATURATION_MARGIN || value >= ADC_MAX_VALUE - ADC_SATURATION_MARGIN;
+  if (detector->saturated) {
+    if (!was_saturated && detector->restore_count == 0) {
+      clear_filters(detector);
+      detector->rr_count = 0;
+      detector->has_r_peak = false;
+    }
+    detector->restore_count = FAST_RESTORE_SAMPLES;
+  }
+  else if (detector->restore_count > 0) {
+    detector->restore_count--;
+  }
+  return detector->saturated || was_saturated;
+}
+
+/*
+    Copies the adapted state of the detector. Returns false while the detector hasn't converged yet, as there is
+    nothing worth keeping then.
+*/
+bool get_pan_tompkins_state(const pt_detector_t* detector, pt_state_t* state) {
+  if (!detector->rr_seeded || detector->learning_count < FILTER_SETTLE_SAMPLES + params.learning_samples) {
+    return false;
+  }
+  state->signalpeak_i = detector->signalpeak_i;
+  state->noisepeak_i = detector->noisepeak_i;
+  state->signalpeak_f = detector->signalpeak_f;
+  state->noisepeak_f = detector->noisepeak_f;
+  state->rr_average = detector->rravg1;
+  state->rr_average2 = detector->rravg2;
+  return true;
+}
+
+static bool is_plausible_peak_pair(float signalpeak, float noisepeak) {
+  return isfinite(signalpeak) && isfinite(noisepeak) && noisepeak >= 0 && signalpeak > noisepeak;
+}
+
+/*
+    Starts the detector from a previously saved state instead of learning it again: the peak estimates seed the
+    thresholds and the RR averages fill the RR buffers. A state that doesn't look like a converged detector (non
+    finite or inverted peak estimates, RR averages out of the 30..200 BPM range) is rejected with false, and the
+    detector stays with the learning phase.
+*/
+bool restore_pan_tompkins_state(pt_detector_t* detector, const pt_state_t* state) {
+  if (!is_plausible_peak_pair(state->signalpeak_i, state->noisepeak_i) ||
+      !is_plausible_peak_pair(state->signalpeak_f, state->noisepeak_f) ||
+      state->rr_average < MIN_LEARNING_RR || state->rr_average > MAX_LEARNING_RR ||
+      state->rr_average2 < MIN_LEARNING_RR || state->rr_average2 > MAX_LEARNING_RR) {
+    return false;
+  }
+
+  detector->signalpeak_i = state->signalpeak_i;
+  detector->noisepeak_i = state->noisepeak_i;
+  detector->threshold_i1 = detector->noisepeak_i + params.threshold_fraction * (detector->signalpeak_i - detector->noisepeak_i);
+  detector->threshold_i2 = 0.5 * detector->threshold_i1;
+
+  detector->signalpeak_f = state->signalpeak_f;
+  detector->noisepeak_f = state->noisepeak_f;
+  detector->threshold_f1 = detector->noisepeak_f + params.threshold_fraction * (detector->signalpeak_f - detector->noisepeak_f);
+  detector->threshold_f2 = 0.5 * detector->threshold_f1;
+
+  for (uint8_t i = 0; i <= MAX_RR_AVERAGE_INDEX; i++) {
+    detector->rr1[i] = state->rr_average;
+    detector->rr2[i] = state->rr_average2;
+  }
+  detector->rravg1 = state->rr_average;
+  detector->rravg2 = state->rr_average2;
+  detector->rrlow = params.rr_low_limit * detector->rravg2;
+  detector->rrhigh = params.rr_high_limit * detector->rravg2;
+  detector->rrmiss = params.rr_miss_limit * detector->rravg2;
+  detector->last_rr_average_index = MAX_RR_AVERAGE_INDEX;
+  detector->regular = detector->rravg1 <= detector->rravg2 + 2 && detector->rravg1 >= detector->rravg2 - 2;
+  detector->rr_seeded = true;
+  detector->thresholds_known = true;
+  return true;
+}
+
+/*
+    Learning phase 1. After the filters settled, the first learning_samples samples of the integrator and of the
+    filtered signal are observed. The signal peaks are seeded with a third of their maxima and the noise peaks with
+    half of their averages, so the thresholds are usable when the decision logic starts. With already known peak
+    estimates only the settling of the filters is waited for.
+    Returns true while the phase is still running.
+*/
+static bool learn_thresholds(pt_detector_t* detector, float integral_value, float highpass_value) {
+  detector->learning_count++;
+  if (detector->learning_count <= FILTER_SETTLE_SAMPLES) {
+    return true;
+  }
+  if (detector->thresholds_known) {
+    detector->learning_count = FILTER_SETTLE_SAMPLES + params.learning_samples;
+    return false;
+  }
+
+  if (integral_value > detector->learning_max_i) {
+    detector->learning_max_i = integral_value;
+  }
+  if (highpass_value > detector->learning_max_f) {
+    detector->learning_max_f = highpass_value;
+  }
+  detector->learning_sum_i += integral_value;
+  detector->learning_sum_f += highpass_value < 0 ? -highpass_value : highpass_value;
+
+  if (detector->learning_count < FILTER_SETTLE_SAMPLES + params.learning_samples) {
+    return true;
+  }
+
+  detector->signalpeak_i = detector->learning_max_i / 3;
+  detector->noisepeak_i = detector->learning_sum_i / params.learning_samples / 2;
+  detector->threshold_i1 = detector->noisepeak_i + params.threshold_fraction * (detector->signalpeak_i - detector->noisepeak_i);
+  detector->threshold_i2 = 0.5 * detector->threshold_i1;
+
+  detector->signalpeak_f = detector->learning_max_f / 3;
+  detector->noisepeak_f = detector->learning_sum_f / params.learning_samples / 2;
+  detector->threshold_f1 = detector->noisepeak_f + params.threshold_fraction * (detector->signalpeak_f - detector->noisepeak_f);
+  detector->threshold_f2 = 0.5 * detector->threshold_f1;
+  return false;
+}
+
+/*
+    Learning phase 2. The first plausible RR interval fills both RR buffers, so that the averages and the limits of
+    a normal beat are valid from the second detected beat on, instead of after MAX_RR_AVERAGE_INDEX + 1 beats.
+*/
+static void seed_rr_averages(pt_detector_t* detector, uint16_t rr, pt_result_t* result) {
+  if (rr < MIN_LEARNING_RR || rr > MAX_LEARNING_RR) {
+    return;
+  }
+  for (uint8_t i = 0; i <= MAX_RR_AVERAGE_INDEX; i++) {
+    detector->rr1[i] = rr;
+    detector->rr2[i] = rr;
+  }
+  detector->rravg1 = rr;
+  detector->rravg2 = rr;
+  detector->rrlow = params.rr_low_limit * detector->rravg2;
+  detector->rrhigh = params.rr_high_limit * detector->rravg2;
+  detector->rrmiss = params.rr_miss_limit * detector->rravg2;
+  detector->last_rr_average_index = MAX_RR_AVERAGE_INDEX;
+  detector->regular = true;
+  detector->rr_seeded = true;
+
+  result->rr_average = detector->rravg1;
+  result->rr_average2 = detector->rravg2;
+  result->is_regular = detector->regular;
+  result->evaluation = 1;
+}
+
+/*
+    Locates the R peak of a beat candidate detected at current_index. The detection comes when the integrator and
+    the filtered signal cross their thresholds, which is somewhere on the QRS complex and late by the delay of the
+    filters. The largest excursion of the band-pass filtered signal over the integrator window tells the polarity of
+    the R wave and, less the delay of the filters, roughly where it is. The peak is then looked for in the DC blocked
+    signal, which has no delay, and its position interpolated between the samples with a parabola through the peak
+    and its two neighbours. The DC blocked signal up to current_index is known, the search ends
+    BANDPASS_DELAY_SAMPLES - R_PEAK_SEARCH_RADIUS samples before it.
+    The QRS complex around the peak is then matched against the template of the dominant beat.
+*/
+static void locate_r_peak(pt_detector_t* detector, uint32_t current_index) {
+  int32_t estimate = current_index;
+  int32_t largest = 0;
+  for (int32_t i = 0; i < params.window_size && i <= (int32_t) current_index; i++) {
+    int32_t value = detector->highpass[MOD_INDEX((int32_t) current_index - i)];
+    if (value > largest || -value > largest) {
+      largest = value < 0 ? -value : value;
+      estimate = current_index - i;
+    }
+  }
+  int32_t sign = detector->highpass[MOD_INDEX(estimate)] < 0 ? -1 : 1;
+
+  // The search window, kept one sample off the available history so the parabola has both neighbours.
+  int32_t first = estimate - BANDPASS_DELAY_SAMPLES - R_PEAK_SEARCH_RADIUS;
+  int32_t last = estimate - BANDPASS_DELAY_SAMPLES + R_PEAK_SEARCH_RADIUS;
+  if (first < 1) {
+    first = 1;
+  }
+  if (last < first) {
+    last = first;
+  }
+  int32_t peak = first;
+  for (int32_t i = first + 1; i <= last; i++) {
+    if (sign * detector->dcblock[MOD_INDEX(i)] > sign * detector->dcblock[MOD_INDEX(peak)]) {
+      peak = i;
+    }
+  }
+
+  // Vertex of the parabola through y(-1), y(0) and y(1): 0.5 (y(-1) - y(1)) / (y(-1) - 2y(0) + y(1)), in Q8.
+  // Only a true local extremum is interpolated, not one on the edge of the window.
+  int32_t offset_q8 = 0;
+  int32_t before = detector->dcblock[MOD_INDEX(peak - 1)], at = detector->dcblock[MOD_INDEX(peak)];
+  int32_t after = detector->dcblock[MOD_INDEX(peak + 1)];
+  int32_t curvature = before - 2 * at + after;
+  if (sign * curvature < 0 && sign * (at - before) >= 0 && sign * (at - after) >= 0) {
+    offset_q8 = 128 * (before - after) / curvature;
+  }
+  detector->candidate_r_peak_q8 = ((uint32_t) peak << 8) + offset_q8;
+  detector->candidate_amplitude = at;
+
+  for (int32_t i = 0; i < TEMPLATE_SEGMENT_LENGTH; i++) {
+    detector->candidate_segment[i] =
+        detector->dcblock[MOD_INDEX(peak - TEMPLATE_MAX_SHIFT - TEMPLATE_BEFORE_R + i)] >> TEMPLATE_SAMPLE_SHIFT;
+  }
+  match_beat_template(&detector->beat_template, detector->candidate_segment, &detector->candidate_match);
+}
+
+/*
+    Noise rejection. A candidate that doesn't look like the dominant beat, not even inverted (a ventricular beat may
+    be), is noise: motion, an electrode artefact or a tall T wave. Until the template has formed every candidate is
+    taken for a beat.
+*/
+static bool is_noise_candidate(pt_detector_t* detector, uint32_t current_index) {
+  locate_r_peak(detector, current_index);
+  int16_t score = detector->candidate_match.score;
+  return is_beat_template_ready(&detector->beat_template) && score < TEMPLATE_NOISE_SCORE &&
+      score > -TEMPLATE_NOISE_SCORE;
+}
+
+/*
+    Reports the located R peak of a detected beat, classifies its morphology and averages it into the template if
+    it is a dominant beat.
+*/
+static void report_r_peak(pt_detector_t* detector, pt_result_t* result) {
+  result->r_peak_q8 = detector->candidate_r_peak_q8;
+  result->r_amplitude = detector->candidate_amplitude;
+  result->rr_interval_us = detector->has_r_peak ?
+      (uint64_t) (result->r_peak_q8 - detector->last_r_peak_q8) * 1000000 / (SAMPLING_FREQUENCY << 8) : 0;
+  detector->last_r_peak_q8 = result->r_peak_q8;
+  detector->has_r_peak = true;
+
+  result->template_score = detector->candidate_match.score;
+  if (!is_beat_template_ready(&detector->beat_template)) {
+    result->morphology = PT_MORPHOLOGY_UNKNOWN;
+  }
+  else if (result->template_score >= TEMPLATE_DOMINANT_SCORE) {
+    result->morphology = PT_MORPHOLOGY_DOMINANT;
+  }
+  else {
+    result->morphology = PT_MORPHOLOGY_ABERRANT;
+  }
+  update_beat_template(&detector->beat_template, detector->candidate_segment, &detector->candidate_match);
+}
+
+/*
+    Starts the processing of a sample: counts it, handles a saturated input and cancels the mains interference.
+    Returns true if the DC block has to restart from the sample.
+*/
+static bool begin_sample(pt_detector_t* detector, uint16_t* signal, uint32_t current_index) {
+  uint32_t array_index = MOD_INDEX(current_index);
+  detector->sample = current_index + 1l;
+  bool restart_dcblock = fast_restore(detector, signal[array_index]) || current_index == 0;
+  // Mains interference canceller, ahead of the DC block. It doesn't adapt to the transient of a saturated input.
+  bool cancelling = detector->mains.cancelling;
+  detector->cancelled[array_index] = cancel_mains(&detector->mains, signal[array_index], detector->restore_count == 0);
+  // The filter histories and the peaks learned so far carry the interference. If it is taken out during the learning,
+  // they start over without it: learned on a hum larger than the beats, the thresholds would stay above them for good.
+  if (detector->mains.cancelling && !cancelling &&
+      detector->learning_count < FILTER_SETTLE_SAMPLES + params.learning_samples) {
+    clear_filters(detector);
+    restart_learning(detector);
+    restart_dcblock = true;
+  }
+  return restart_dcblock;
+}
+
+static pt_filter_lane_t filter_lane(pt_detector_t* detector) {
+  pt_filter_lane_t lane = { detector->cancelled, detector->dcblock, detector->lowpass, detector->highpass };
+  return lane;
+}
 
 /*
     This is the actual QRS-detecting function. It's a loop that constantly calls the input and output functions
     and updates the thresholds and averages until there are no more samples. More details both above and in
     shorter comments below.
     The output is a buffer where we can change a previous result (using a back search) before outputting.
+    The sample is already band-pass filtered: DC block, low pass and high pass, see pt_filters.c. The DC block was
+    not proposed on the original paper, the low pass and the high pass filters are implemented as proposed there.
 */
-void process_pan_tompkins(uint16_t* signal, float* filtered, uint32_t current_index, pt_result_t* result) {
+static void detect_qrs(pt_detector_t* detector, float* filtered, uint32_t current_index, pt_result_t* result) {
+
+  // i, j and k are iterators for loops, max_index is the index of the last valid RR interval of the buffers.
+  int32_t i, j, k;
+  uint16_t max_index;
 
   // This variable is used as an index to work with the signal buffers. If the buffers still aren't
   // completely filled, it shows the last filled position. Once the buffers are full, it'll always
@@ -235,139 +615,129 @@ void process_pan_tompkins(uint16_t* signal, float* filtered, uint32_t current_in
   // sample and storing the newest one on the last position.
   uint32_t array_index = MOD_INDEX(current_index);
 
-  sample = current_index + 1l;
-  // DC Block filter
-  // This was not proposed on the original paper.
-  // It is not necessary and can be removed if your sensor or database has no DC noise.
-  if (current_index >= 1) {
-    dcblock[array_index] = signal[array_index] - signal[MOD_INDEX(array_index - 1l)] + 0.995 * dcblock[MOD_INDEX(array_index - 1l)];
-  }
-  else {
-    dcblock[array_index] = 0;
-  }
-
-  // Low Pass filter
-  // Implemented as proposed by the original paper.
-  // y(nT) = 2y(nT - T) - y(nT - 2T) + x(nT) - 2x(nT - 6T) + x(nT - 12T)
-  // Can be removed if your signal was previously filtered, or replaced by a different filter.
-  lowpass[array_index] = dcblock[array_index];
-  lowpass[array_index] += 2 * lowpass[MOD_INDEX(array_index - 1)];
-  lowpass[array_index] -= lowpass[MOD_INDEX(array_index - 2)];
-  lowpass[array_index] -= 2 * dcblock[MOD_INDEX(array_index - 6)];
-  lowpass[array_index] += dcblock[MOD_INDEX(array_index - 12)];
-
-  // High Pass filter
-  // Implemented as proposed by the original paper.
-  // y(nT) = 32x(nT - 16T) - [y(nT - T) + x(nT) - x(nT - 32T)]
-  // Can be removed if your signal was previously filtered, or replaced by a different filter.
-  highpass[array_index] = -lowpass[array_index];
-  highpass[array_index] -= highpass[MOD_INDEX(array_index - 1)];
-  highpass[array_index] += 32 * lowpass[MOD_INDEX(array_index - 16)];
-  highpass[array_index] += lowpass[MOD_INDEX(array_index - 32)];
+  result->is_restoring = detector->restore_count > 0;
 
-  filtered[array_index] = highpass[array_index];
+  filtered[array_index] = detector->highpass[array_index];
 
   // Derivative filter
   // This is an alternative implementation, the central difference method.
   // f'(a) = [f(a+h) - f(a-h)]/2h
   // The original formula used by Pan-Tompkins was:
   // y(nT) = (1/8T)[-x(nT - 2T) - 2x(nT - T) + 2x(nT + T) + x(nT + 2T)]
-  derivative[array_index] = highpass[array_index] - highpass[MOD_INDEX(array_index - 1l)];
+  detector->derivative[array_index] = detector->highpass[array_index] - detector->highpass[MOD_INDEX(array_index - 1l)];
 
   // This just squares the derivative, to get rid of negative values and emphasize high frequencies.
   // y(nT) = [x(nT)]^2.
-  squared_derivative[array_index] = derivative[array_index] * derivative[array_index];
+  detector->squared_derivative[array_index] = detector->derivative[array_index] * detector->derivative[array_index];
 
   // Moving-Window Integration
   // Implemented as proposed by the original paper.
   // y(nT) = (1/N)[x(nT - (N - 1)T) + x(nT - (N - 2)T) + ... x(nT)]
   // WINDOW_SIZE, in samples, must be defined so that the window is ~150ms.
 
-  integral[array_index] = 0;
-  for (i = 0; i < WINDOW_SIZE; i++) {
-    integral[array_index] += squared_derivative[MOD_INDEX(array_index - i)];
+  detector->integral[array_index] = 0;
+  for (i = 0; i < params.window_size; i++) {
+    detector->integral[array_index] += detector->squared_derivative[MOD_INDEX(array_index - i)];
   }
-  integral[array_index] /= WINDOW_SIZE;
+  detector->integral[array_index] /= params.window_size;
 
   result->is_qrs = false;
 
-  if (current_index < 600) {
+  if (result->is_restoring) {
+    return;
+  }
+
+  if (detector->learning_count < FILTER_SETTLE_SAMPLES + params.learning_samples &&
+      learn_thresholds(detector, detector->integral[array_index], detector->highpass[array_index])) {
     return;
   }
 
   // Decision making.
 
-  float integral_value = integral[array_index], highpass_value = highpass[array_index];
+  float integral_value = detector->integral[array_index], highpass_value = detector->highpass[array_index];
+
+  // A candidate rejected for its shape is ignored for 200ms, together with the rest of the artefact. It doesn't
+  // update the noise peaks either, an artefact can be much larger than the beats. It counts toward the reseed of the
+  // template, in case it is the dominant beat that has changed.
+  if (detector->sample <= detector->rejected_until) {
+    return;
+  }
+  if (integral_value >= detector->threshold_i1 && highpass_value >= detector->threshold_f1 &&
+      detector->sample > detector->lastQRS + DELAY_200ms_IN_SAMPLES && is_noise_candidate(detector, current_index)) {
+    detector->rejected_until = detector->sample + DELAY_200ms_IN_SAMPLES;
+    reject_beat_template_candidate(&detector->beat_template);
+    return;
+  }
 
   // If the array_index signal is above one of the thresholds (integral or filtered signal), it's a peak candidate.
-  if (integral_value >= threshold_i1 || highpass_value >= threshold_f1) {
-      peak_i = integral_value;
-      peak_f = highpass_value;
+  if (integral_value >= detector->threshold_i1 || highpass_value >= detector->threshold_f1) {
+      detector->peak_i = integral_value;
+      detector->peak_f = highpass_value;
   }
 
   // If both the integral and the signal are above their thresholds, they're probably signal peaks.
-  if (integral_value >= threshold_i1 && highpass_value >= threshold_f1) {
+  if (integral_value >= detector->threshold_i1 && highpass_value >= detector->threshold_f1) {
     // There's a 200ms latency. If the new peak respects this condition, we can keep testing.
-    if (sample > lastQRS + DELAY_200ms_IN_SAMPLES) {
+    if (detector->sample > detector->lastQRS + DELAY_200ms_IN_SAMPLES) {
         // If it respects the 200ms latency, but it doesn't respect the 360ms latency, we check the slope.
-      if (sample <= lastQRS + DELAY_360ms_IN_SAMPLES) {
+      if (detector->sample <= detector->lastQRS + DELAY_360ms_IN_SAMPLES) {
         // The squared slope is "M" shaped. So we have to check nearby samples to make sure we're really looking
         // at its peak value, rather than a low one.
-        currentSlope = 0;
+        detector->currentSlope = 0;
         for (j = current_index - 10; j <= current_index; j++) {
           k = MOD_INDEX(j);
-          if (squared_derivative[k] > currentSlope) {
-              currentSlope = squared_derivative[k];
+          if (detector->squared_derivative[k] > detector->currentSlope) {
+              detector->currentSlope = detector->squared_derivative[k];
           }
         }
-        if (currentSlope <= lastSlope / 2l) {
+        if (detector->currentSlope <= detector->lastSlope / 2l) {
           result->is_qrs = false;
         }
         else {
-          signalpeak_i = 0.125 * peak_i + 0.875 * signalpeak_i;
-          threshold_i1 = noisepeak_i + 0.25 * (signalpeak_i - noisepeak_i);
-          threshold_i2 = 0.5 * threshold_i1;
+          detector->signalpeak_i = params.peak_weight * detector->peak_i + (1 - params.peak_weight) * detector->signalpeak_i;
+          detector->threshold_i1 = detector->noisepeak_i + params.threshold_fraction * (detector->signalpeak_i - detector->noisepeak_i);
+          detector->threshold_i2 = 0.5 * detector->threshold_i1;
 
-          signalpeak_f = 0.125 * peak_f + 0.875 * signalpeak_f;
-          threshold_f1 = noisepeak_f + 0.25 * (signalpeak_f - noisepeak_f);
-          threshold_f2 = 0.5 * threshold_f1;
+          detector->signalpeak_f = params.peak_weight * detector->peak_f + (1 - params.peak_weight) * detector->signalpeak_f;
+          detector->threshold_f1 = detector->noisepeak_f + params.threshold_fraction * (detector->signalpeak_f - detector->noisepeak_f);
+          detector->threshold_f2 = 0.5 * detector->threshold_f1;
 
-          lastSlope = currentSlope;
+          detector->lastSlope = detector->currentSlope;
           result->is_qrs = true;
         }
       }
       // If it was above both thresholds and respects both latency periods, it certainly is an R peak.
       else {
-        currentSlope = 0;
+        detector->currentSlope = 0;
         for (j = current_index - 10; j <= current_index; j++) {
           k = MOD_INDEX(j);
-          if (squared_derivative[k] > currentSlope) {
-              currentSlope = squared_derivative[k];
+          if (detector->squared_derivative[k] > detector->currentSlope) {
+              detector->currentSlope = detector->squared_derivative[k];
           }
         }
-        signalpeak_i = 0.125 * peak_i + 0.875 * signalpeak_i;
-        threshold_i1 = noisepeak_i + 0.25 * (signalpeak_i - noisepeak_i);
-        threshold_i2 = 0.5 * threshold_i1;
+        detector->signalpeak_i = params.peak_weight * detector->peak_i + (1 - params.peak_weight) * detector->signalpeak_i;
+        detector->threshold_i1 = detector->noisepeak_i + params.threshold_fraction * (detector->signalpeak_i - detector->noisepeak_i);
+        detector->threshold_i2 = 0.5 * detector->threshold_i1;
 
-        signalpeak_f = 0.125 * peak_f + 0.875 * signalpeak_f;
-        threshold_f1 = noisepeak_f + 0.25 * (signalpeak_f - noisepeak_f);
-        threshold_f2 = 0.5 * threshold_f1;
+        detector->signalpeak_f = params.peak_weight * detector->peak_f + (1 - params.peak_weight) * detector->signalpeak_f;
+        detector->threshold_f1 = detector->noisepeak_f + params.threshold_fraction * (detector->signalpeak_f - detector->noisepeak_f);
+        detector->threshold_f2 = 0.5 * detector->threshold_f1;
 
-        lastSlope = currentSlope;
+        detector->lastSlope = detector->currentSlope;
         result->is_qrs = true;
       }
     }
     // If the new peak doesn't respect the 200ms latency, it's noise. Update thresholds and move on to the next sample.
     else {
-      peak_i = integral_value;
-      noisepeak_i = 0.125 * peak_i + 0.875 * noisepeak_i;
-      threshold_i1 = noisepeak_i + 0.25 * (signalpeak_i - noisepeak_i);
-      threshold_i2 = 0.5 * threshold_i1;
+      detector->peak_i = integral_value;
+      detector->noisepeak_i = params.peak_weight * detector->peak_i + (1 - params.peak_weight) * detector->noisepeak_i;
+      detector->threshold_i1 = detector->noisepeak_i + params.threshold_fraction * (detector->signalpeak_i - detector->noisepeak_i);
+      detector->threshold_i2 = 0.5 * detector->threshold_i1;
 
-      peak_f = highpass_value;
-      noisepeak_f = 0.125 * peak_f + 0.875 * noisepeak_f;
-      threshold_f1 = noisepeak_f + 0.25 * (signalpeak_f - noisepeak_f);
-      threshold_f2 = 0.5 * threshold_f1;
+      detector->peak_f = highpass_value;
+      detector->noisepeak_f = params.peak_weight * detector->peak_f + (1 - params.peak_weight) * detector->noisepeak_f;
+      detector->threshold_f1 = detector->noisepeak_f + params.threshold_fraction * (detector->signalpeak_f - detector->noisepeak_f);
+      detector->threshold_f2 = 0.5 * detector->threshold_f1;
 
       result->is_qrs = false;
     }
@@ -375,149 +745,156 @@ void process_pan_tompkins(uint16_t* signal, float* filtered, uint32_t current_in
 
   // If a R-peak was detected, the RR-averages must be updated.
   if (result->is_qrs) {
+    result->detection_path = PT_DETECTION_PRIMARY;
+    report_r_peak(detector, result);
     // Skip the first RR intervals as there are incorrect ones that affect the average.
-    if (rr_count > RR_INTERVALS_TO_SKIP) {
+    if (detector->rr_count > params.rr_intervals_to_skip && !detector->rr_seeded) {
+      seed_rr_averages(detector, detector->sample - detector->lastQRS, result);
+    }
+    else if (detector->rr_count > params.rr_intervals_to_skip) {
       // Add the newest RR-interval to the buffer and get the new average.
-      rravg1 = 0;
-      max_index = last_rr_average_index;
+      detector->rravg1 = 0;
+      max_index = detector->last_rr_average_index;
       for (i = 0; i < MAX_RR_AVERAGE_INDEX; i++) {
-        rr1[i] = rr1[i + 1];
-        rravg1 += rr1[i];
+        detector->rr1[i] = detector->rr1[i + 1];
+        detector->rravg1 += detector->rr1[i];
       }
-      rr1[MAX_RR_AVERAGE_INDEX] = sample - lastQRS;
-      rravg1 += rr1[MAX_RR_AVERAGE_INDEX];
-      rravg1 /= max_index + 1;
+      detector->rr1[MAX_RR_AVERAGE_INDEX] = detector->sample - detector->lastQRS;
+      detector->rravg1 += detector->rr1[MAX_RR_AVERAGE_INDEX];
+      detector->rravg1 /= max_index + 1;
 
       // If the newly-discovered RR-average is normal, add it to the "normal" buffer and get the new "normal" average.
       // Update the "normal" beat parameters.
-      if (rr1[MAX_RR_AVERAGE_INDEX] >= rrlow && rr1[MAX_RR_AVERAGE_INDEX] <= rrhigh) {
-        rravg2 = 0;
+      if (detector->rr1[MAX_RR_AVERAGE_INDEX] >= detector->rrlow && detector->rr1[MAX_RR_AVERAGE_INDEX] <= detector->rrhigh) {
+        detector->rravg2 = 0;
         for (i = 0; i < MAX_RR_AVERAGE_INDEX; i++) {
-          rr2[i] = rr2[i + 1];
-          rravg2 += rr2[i];
+          detector->rr2[i] = detector->rr2[i + 1];
+          detector->rravg2 += detector->rr2[i];
         }
-        rr2[MAX_RR_AVERAGE_INDEX] = rr1[MAX_RR_AVERAGE_INDEX];
-        rravg2 += rr2[MAX_RR_AVERAGE_INDEX];
-        rravg2 /= max_index + 1;
+        detector->rr2[MAX_RR_AVERAGE_INDEX] = detector->rr1[MAX_RR_AVERAGE_INDEX];
+        detector->rravg2 += detector->rr2[MAX_RR_AVERAGE_INDEX];
+        detector->rravg2 /= max_index + 1;
 
-        rrlow = 0.92 * rravg2;
-        rrhigh = 1.16 * rravg2;
-        rrmiss = 1.66 * rravg2;
+        detector->rrlow = params.rr_low_limit * detector->rravg2;
+        detector->rrhigh = params.rr_high_limit * detector->rravg2;
+        detector->rrmiss = params.rr_miss_limit * detector->rravg2;
       }
 
-      prevRegular = regular;
-      if (rravg1 <= rravg2+2 && rravg1 >= rravg2-2) {
-        regular = true;
+      detector->prevRegular = detector->regular;
+      if (detector->rravg1 <= detector->rravg2+2 && detector->rravg1 >= detector->rravg2-2) {
+        detector->regular = true;
       }
       // If the beat had been normal but turned odd, change the thresholds.
       else {
-        regular = false;
-        if (prevRegular) {
-          threshold_i1 *= 0.5;
-          threshold_f1 *= 0.5;
+        detector->regular = false;
+        if (detector->prevRegular) {
+          detector->threshold_i1 *= 0.5;
+          detector->threshold_f1 *= 0.5;
         }
       }
-      if (last_rr_average_index < MAX_RR_AVERAGE_INDEX) {
-        last_rr_average_index++;
+      if (detector->last_rr_average_index < MAX_RR_AVERAGE_INDEX) {
+        detector->last_rr_average_index++;
       }
-      result->rr_average = rravg1;
-      result->rr_average2 = rravg2;
-      result->is_regular = regular;
-      result->evaluation = regular ? 1 : 2;
+      result->rr_average = detector->rravg1;
+      result->rr_average2 = detector->rravg2;
+      result->is_regular = detector->regular;
+      result->evaluation = detector->regular ? 1 : 2;
     }
     else {
-      rr_count++;
+      detector->rr_count++;
     }
-    lastQRS = sample;
+    detector->lastQRS = detector->sample;
   }
   // If no R-peak was detected, it's important to check how long it's been since the last detection.
   else {
     // If no R-peak was detected for too long, use the lighter thresholds and do a back search.
     // However, the back search must respect the 200ms limit and the 360ms one (check the slope).
-    if (false && sample > (lastQRS + DELAY_200ms_IN_SAMPLES)) {
-      for (k = lastQRS - 1 + DELAY_200ms_IN_SAMPLES; k < current_index; k++) {
+    // Disabled: no beat is reported with PT_DETECTION_SEARCH_BACK, see beat_queue.h.
+    if (false && detector->sample > (detector->lastQRS + DELAY_200ms_IN_SAMPLES)) {
+      for (k = detector->lastQRS - 1 + DELAY_200ms_IN_SAMPLES; k < current_index; k++) {
         i = MOD_INDEX(k);
-        if (integral[i] > threshold_i2 && highpass[i] > threshold_f1) {
-          currentSlope = 0;
+        if (detector->integral[i] > detector->threshold_i2 && detector->highpass[i] > detector->threshold_f1) {
+          detector->currentSlope = 0;
           for (j = i - 10; j <= i; j++) {
-            if (squared_derivative[MOD_INDEX(j)] > currentSlope) {
-                currentSlope = squared_derivative[MOD_INDEX(j)];
+            if (detector->squared_derivative[MOD_INDEX(j)] > detector->currentSlope) {
+                detector->currentSlope = detector->squared_derivative[MOD_INDEX(j)];
             }
           }
-          if (currentSlope < (lastSlope / 2l) && (i + sample) < (lastQRS + 0.36 * lastQRS)) { // TODO miért 2?
+          if (detector->currentSlope < (detector->lastSlope / 2l) && (i + detector->sample) < (detector->lastQRS + 0.36 * detector->lastQRS)) { // TODO miért 2?
               result->is_qrs = false;
           }
           else {
-            peak_i = integral[i];
-            signalpeak_i = 0.25 * peak_i + 0.75 * signalpeak_i; // 0.25 *
-            threshold_i1 = noisepeak_i + 0.25 * (signalpeak_i - noisepeak_i); // 0.25 *
-            threshold_i2 = 0.5 * threshold_i1; // 0.5 *
-            lastSlope = currentSlope;
+            detector->peak_i = detector->integral[i];
+            detector->signalpeak_i = 0.25 * detector->peak_i + 0.75 * detector->signalpeak_i; // 0.25 *
+            detector->threshold_i1 = detector->noisepeak_i + params.threshold_fraction * (detector->signalpeak_i - detector->noisepeak_i); // 0.25 *
+            detector->threshold_i2 = 0.5 * detector->threshold_i1; // 0.5 *
+            detector->lastSlope = detector->currentSlope;
             // If a signal peak was detected on the back search, the RR attributes must be updated.
             // This is the same thing done when a peak is detected on the first try.
-            max_index = last_rr_average_index;
-            rravg1 = 0;
+            max_index = detector->last_rr_average_index;
+            detector->rravg1 = 0;
             for (j = MAX_RR_AVERAGE_INDEX - max_index; j < MAX_RR_AVERAGE_INDEX; j++) {
-              rr1[j] = rr1[j + 1];
-              rravg1 += rr1[j];
+              detector->rr1[j] = detector->rr1[j + 1];
+              detector->rravg1 += detector->rr1[j];
             }
-            rr1[MAX_RR_AVERAGE_INDEX] = k - 1 - lastQRS;
-            lastQRS = k - 1;
-            rravg1 += rr1[MAX_RR_AVERAGE_INDEX];
-            rravg1 /= max_index + 1;
+            detector->rr1[MAX_RR_AVERAGE_INDEX] = k - 1 - detector->lastQRS;
+            detector->lastQRS = k - 1;
+            detector->rravg1 += detector->rr1[MAX_RR_AVERAGE_INDEX];
+            detector->rravg1 /= max_index + 1;
             result->is_qrs = true;
+            result->detection_path = PT_DETECTION_SEARCH_BACK;
 
-            if (rr1[MAX_RR_AVERAGE_INDEX] >= rrlow && rr1[MAX_RR_AVERAGE_INDEX] <= rrhigh) {
-              rravg2 = 0;
+            if (detector->rr1[MAX_RR_AVERAGE_INDEX] >= detector->rrlow && detector->rr1[MAX_RR_AVERAGE_INDEX] <= detector->rrhigh) {
+              detector->rravg2 = 0;
               for (j = MAX_RR_AVERAGE_INDEX - max_index; j < MAX_RR_AVERAGE_INDEX; j++) {
-                rr2[j] = rr2[j + 1];
-                rravg2 += rr2[j];
+                detector->rr2[j] = detector->rr2[j + 1];
+                detector->rravg2 += detector->rr2[j];
               }
-              rr2[MAX_RR_AVERAGE_INDEX] = rr1[MAX_RR_AVERAGE_INDEX];
-              rravg2 += rr2[MAX_RR_AVERAGE_INDEX];
-              rravg2 /= max_index + 1;
-              rrlow = 0.92 * rravg2;
-              rrhigh = 1.16 * rravg2;
-              rrmiss = 1.66 * rravg2;
+              detector->rr2[MAX_RR_AVERAGE_INDEX] = detector->rr1[MAX_RR_AVERAGE_INDEX];
+              detector->rravg2 += detector->rr2[MAX_RR_AVERAGE_INDEX];
+              detector->rravg2 /= max_index + 1;
+              detector->rrlow = params.rr_low_limit * detector->rravg2;
+              detector->rrhigh = params.rr_high_limit * detector->rravg2;
+              detector->rrmiss = params.rr_miss_limit * detector->rravg2;
             }
 
-            prevRegular = regular;
-            if (rravg1 == rravg2) {
-              regular = true;
+            detector->prevRegular = detector->regular;
+            if (detector->rravg1 == detector->rravg2) {
+              detector->regular = true;
             }
             else {
-              regular = false;
-              if (prevRegular) {
-                threshold_i1 = 0.5 * threshold_i1;
+              detector->regular = false;
+              if (detector->prevRegular) {
+                detector->threshold_i1 = 0.5 * detector->threshold_i1;
               }
             }
-            if (last_rr_average_index < MAX_RR_AVERAGE_INDEX) {
-              last_rr_average_index++;
+            if (detector->last_rr_average_index < MAX_RR_AVERAGE_INDEX) {
+              detector->last_rr_average_index++;
             }
-            lastQRS = sample;
+            detector->lastQRS = detector->sample;
             break;
           }
         }
       }
       if (result->is_qrs) {
-        result->is_regular = regular;
-        result->rr_average = rravg1;
+        result->is_regular = detector->regular;
+        result->rr_average = detector->rravg1;
       }
     }
 
     // Definitely no signal peak was detected.
     if (!result->is_qrs) {
       // If some kind of peak had been detected, then it's certainly a noise peak. Thresholds must be updated accordingly.
-      if (integral_value >= threshold_i1 || highpass_value >= threshold_f1) {
-        peak_i = integral_value;
-        noisepeak_i = 0.125 * peak_i + 0.875 * noisepeak_i;
-        threshold_i1 = noisepeak_i + 0.25 * (signalpeak_i - noisepeak_i);
-        threshold_i2 = 0.5 * threshold_i1;
-
-        peak_f = highpass_value;
-        noisepeak_f = 0.125 * peak_f + 0.875 * noisepeak_f;
-        threshold_f1 = noisepeak_f + 0.25 * (signalpeak_f - noisepeak_f);
-        threshold_f2 = 0.5 * threshold_f1;
+      if (integral_value >= detector->threshold_i1 || highpass_value >= detector->threshold_f1) {
+        detector->peak_i = integral_value;
+        detector->noisepeak_i = params.peak_weight * detector->peak_i + (1 - params.peak_weight) * detector->noisepeak_i;
+        detector->threshold_i1 = detector->noisepeak_i + params.threshold_fraction * (detector->signalpeak_i - detector->noisepeak_i);
+        detector->threshold_i2 = 0.5 * detector->threshold_i1;
+
+        detector->peak_f = highpass_value;
+        detector->noisepeak_f = params.peak_weight * detector->peak_f + (1 - params.peak_weight) * detector->noisepeak_f;
+        detector->threshold_f1 = detector->noisepeak_f + params.threshold_fraction * (detector->signalpeak_f - detector->noisepeak_f);
+        detector->threshold_f2 = 0.5 * detector->threshold_f1;
       }
     }
   }
@@ -525,16 +902,16 @@ void process_pan_tompkins(uint16_t* signal, float* filtered, uint32_t current_in
 
   if (!result->is_qrs) {
     // If some kind of peak had been detected, then it's certainly a noise peak. Thresholds must be updated accordingly.
-    if ((integral_value >= threshold_i1) || (highpass_value >= threshold_f1)) {
-      peak_i = integral_value;
-      noisepeak_i = 0.125 * peak_i + 0.875 * noisepeak_i;
-      threshold_i1 = noisepeak_i + 0.25 * (signalpeak_i - noisepeak_i);
-      threshold_i2 = 0.5 * threshold_i1;
-
-      peak_f = highpass_value;
-      noisepeak_f = 0.125 * peak_f + 0.875 * noisepeak_f;
-      threshold_f1 = noisepeak_f + 0.25 * (signalpeak_f - noisepeak_f);
-      threshold_f2 = 0.5 * threshold_f1;
+    if ((integral_value >= detector->threshold_i1) || (highpass_value >= detector->threshold_f1)) {
+      detector->peak_i = integral_value;
+      detector->noisepeak_i = params.peak_weight * detector->peak_i + (1 - params.peak_weight) * detector->noisepeak_i;
+      detector->threshold_i1 = detector->noisepeak_i + params.threshold_fraction * (detector->signalpeak_i - detector->noisepeak_i);
+      detector->threshold_i2 = 0.5 * detector->threshold_i1;
+
+      detector->peak_f = highpass_value;
+      detector->noisepeak_f = params.peak_weight * detector->peak_f + (1 - params.peak_weight) * detector->noisepeak_f;
+      detector->threshold_f1 = detector->noisepeak_f + params.threshold_fraction * (detector->signalpeak_f - detector->noisepeak_f);
+      detector->threshold_f2 = 0.5 * detector->threshold_f1;
     }
   }
 
@@ -545,8 +922,84 @@ void process_pan_tompkins(uint16_t* signal, float* filtered, uint32_t current_in
   // However, it updates a few samples back from the buffer. The reason is that if we update the detection
   // for the current_index sample, we might miss a peak that could've been found later by backsearching using
   // lighter thresholds. The final waveform output does match the original signal, though.
-  result->peaki = peak_i;
-  result->signalpeaki = signalpeak_i;
-  result->noisepeaki = noisepeak_i;
-  result->thi1 = threshold_i1;
+  result->peaki = detector->peak_i;
+  result->signalpeaki = detector->signalpeak_i;
+  result->noisepeaki = detector->noisepeak_i;
+  result->thi1 = detector->threshold_i1;
+}
+
+/*
+    Processes the sample at current_index of a lead.
+*/
+void process_pan_tompkins(pt_detector_t* detector, uint16_t* signal, float* filtered, uint32_t current_index,
+    pt_result_t* result) {
+  pt_filter_lane_t lane = filter_lane(detector);
+  bool restart_dcblock = begin_sample(detector, signal, current_index);
+  pt_filter(&lane, MOD_INDEX(current_index), restart_dcblock);
+  detect_qrs(detector, filtered, current_index, result);
+}
+
+/*
+    Starts the fusion of the beats, the reported beats are pushed to queue (may be NULL).
+*/
+void reset_beat_fusion(pt_fusion_t* fusion, pt_beat_queue_t* queue) {
+  memset(fusion, 0, sizeof(pt_fusion_t));
+  fusion->queue = queue;
+}
+
+/*
+    Votes on the beats detected on the leads, to be called after the detectors of all leads processed the sample at
+    current_index. Detections within FUSION_WINDOW_SAMPLES of the first one belong to the same beat candidate, which
+    is reported as soon as a strict majority of the leads detected it: the only lead, both of two leads, two of
+    three. With two leads a beat is only reported if both agree, so a false detection on one lead (motion on its
+    electrodes) doesn't make a beat; a beat lost in the noise of one lead is lost as well. New candidates are not
+    opened within 200ms of a reported beat.
+    fused is updated as the result of the detector of the lead that detected the beat first, with is_qrs set only on
+    the sample the beat is reported, and the beat is pushed to the queue of the fusion.
+*/
+void fuse_beats(pt_fusion_t* fusion, const pt_result_t* results, uint8_t lead_count, uint32_t current_index,
+    pt_result_t* fused) {
+  fused->is_qrs = false;
+
+  if (fusion->votes != 0 && current_index > fusion->candidate_index + FUSION_WINDOW_SAMPLES) {
+    fusion->votes = 0;
+  }
+
+  for (uint8_t lead = 0; lead < lead_count; lead++) {
+    if (!results[lead].is_qrs) {
+      continue;
+    }
+    if (fusion->votes == 0) {
+      if (fusion->has_beat && current_index <= fusion->last_beat_index + DELAY_200ms_IN_SAMPLES) {
+        continue;
+      }
+      fusion->candidate_index = current_index;
+      fusion->first_lead = lead;
+      fusion->emitted = false;
+    }
+    fusion->votes |= 1 << lead;
+  }
+
+  if (fusion->votes != 0 && !fusion->emitted && __builtin_popcount(fusion->votes) > lead_count / 2) {
+    fusion->emitted = true;
+    fusion->has_beat = true;
+    fusion->last_beat_index = current_index;
+    *fused = results[fusion->first_lead];
+    fused->is_qrs = true;
+    if (fusion->queue != NULL) {
+      pt_beat_event_t event = {
+        .sample_index = current_index,
+        .r_peak_q8 = fused->r_peak_q8,
+        .rr_interval_us = fused->rr_interval_us,
+        .rr_average = fused->rr_average,
+        .evaluation = fused->evaluation,
+        .amplitude = fused->r_amplitude,
+        .template_score = fused->template_score,
+        .morphology = fused->morphology,
+        .detection_path = fused->detection_path,
+        .lead = fusion->first_lead
+      };
+      push_beat_event(fusion->queue, &event);
+    }
+  }
 }
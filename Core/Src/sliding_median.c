@@ -0,0 +1,135 @@
+#include "stm32l4xx_hal.h"
+#include <stdbool.h>
+#include "sliding_median.h"
+
+/*
+    Sliding window median with two heaps sharing their root, the well known "Mediator" design.
+    The median sits at heap position 0, the lower half of the window in a max-heap at the negative positions
+    (children of -i are -2i and -2i-1), the upper half in a min-heap at the positive positions (children of i are 2i
+    and 2i+1). The window is always full: a new sample replaces the oldest one at its heap position, then moves up or
+    down its heap, and through the median to the other heap if needed. That's O(log size) per sample, with no
+    sorting and no allocation.
+*/
+
+#define HEAP(m, i) ((m)->heap[(i) + (m)->size / 2])
+
+static bool less(const sliding_median_t* median, int16_t i, int16_t j) {
+  return median->data[HEAP(median, i)] < median->data[HEAP(median, j)];
+}
+
+static void exchange(sliding_median_t* median, int16_t i, int16_t j) {
+  uint8_t item = HEAP(median, i);
+  HEAP(median, i) = HEAP(median, j);
+  HEAP(median, j) = item;
+  median->pos[HEAP(median, i)] = i;
+  median->pos[HEAP(median, j)] = j;
+}
+
+// Moves the item at position i (the median or an item of the min-heap) down the min-heap.
+static void min_sort_down(sliding_median_t* median, int16_t i) {
+  int16_t half = median->size / 2;
+  while (true) {
+    int16_t child = i == 0 ? 1 : 2 * i;
+    if (child > half) {
+      return;
+    }
+    if (child > 1 && child < half && less(median, child + 1, child)) {
+      child++;
+    }
+    if (!less(median, child, i)) {
+      return;
+    }
+    exchange(median, child, i);
+    i = child;
+  }
+}
+
+// Moves the item at position i (the median or an item of the max-heap) down the max-heap.
+static void max_sort_down(sliding_median_t* median, int16_t i) {
+  int16_t half = median->size / 2;
+  while (true) {
+    int16_t child = i == 0 ? -1 : 2 * i;
+    if (child < -half) {
+      return;
+    }
+    if (child < -1 && child > -half && less(median, child, child - 1)) {
+      child--;
+    }
+    if (!less(median, i, child)) {
+      return;
+    }
+    exchange(median, i, child);
+    i = child;
+  }
+}
+
+// Moves the item at position i of the min-heap up, returns true if it became the median.
+static bool min_sort_up(sliding_median_t* median, int16_t i) {
+  while (i > 0 && less(median, i, i / 2)) {
+    exchange(median, i, i / 2);
+    i /= 2;
+  }
+  return i == 0;
+}
+
+// Moves the item at position i of the max-heap up, returns true if it became the median.
+static bool max_sort_up(sliding_median_t* median, int16_t i) {
+  while (i < 0 && less(median, i / 2, i)) {
+    exchange(median, i / 2, i);
+    i /= 2;
+  }
+  return i == 0;
+}
+
+void sliding_median_init(sliding_median_t* median, int16_t* data, int16_t* pos, uint8_t* heap, uint8_t size) {
+  median->data = data;
+  median->pos = pos;
+  median->heap = heap;
+  median->size = size;
+  sliding_median_fill(median, 0);
+}
+
+/*
+    Fills the whole window with value.
+*/
+void sliding_median_fill(sliding_median_t* median, int16_t value) {
+  // Any arrangement of equal items is a valid pair of heaps. The items alternate between the two heaps.
+  for (uint8_t k = 0; k < median->size; k++) {
+    median->data[k] = value;
+    median->pos[k] = ((k + 1) / 2) * (k & 1 ? -1 : 1);
+    HEAP(median, median->pos[k]) = k;
+  }
+  median->index = 0;
+}
+
+/*
+    Replaces the oldest sample of the window with value. Returns the median of the window.
+*/
+int16_t sliding_median_insert(sliding_median_t* median, int16_t value) {
+  int16_t old = median->data[median->index];
+  int16_t p = median->pos[median->index];
+  median->data[median->index] = value;
+  median->index = median->index + 1 == median->size ? 0 : median->index + 1;
+
+  if (p > 0) {
+    if (old < value) {
+      min_sort_down(median, p);
+    }
+    else if (min_sort_up(median, p)) {
+      max_sort_down(median, 0);
+    }
+  }
+  else if (p < 0) {
+    if (value < old) {
+      max_sort_down(median, p);
+    }
+    else if (max_sort_up(median, p)) {
+      min_sort_down(median, 0);
+    }
+  }
+  else {
+    max_sort_down(median, 0);
+    min_sort_down(median, 0);
+  }
+  return median->data[HEAP(median, 0)];
+}
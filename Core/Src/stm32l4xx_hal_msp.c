@@ -145,6 +145,17 @@ void HAL_ADC_MspInit(ADC_HandleTypeDef* hadc)
 
   /* USER CODE BEGIN ADC1_MspInit 1 */
 
+#if LEAD_COUNT > 1
+    GPIO_InitStruct.Pin = LEAD2_Pin;
+    GPIO_InitStruct.Mode = GPIO_MODE_ANALOG_ADC_CONTROL;
+    GPIO_InitStruct.Pull = GPIO_NOPULL;
+    HAL_GPIO_Init(LEAD2_GPIO_Port, &GPIO_InitStruct);
+#endif
+#if LEAD_COUNT > 2
+    GPIO_InitStruct.Pin = LEAD3_Pin;
+    HAL_GPIO_Init(LEAD3_GPIO_Port, &GPIO_InitStruct);
+#endif
+
   /* USER CODE END ADC1_MspInit 1 */
 
   }
@@ -176,6 +187,13 @@ void HAL_ADC_MspDeInit(ADC_HandleTypeDef* hadc)
     HAL_DMA_DeInit(hadc->DMA_Handle);
   /* USER CODE BEGIN ADC1_MspDeInit 1 */
 
+#if LEAD_COUNT > 1
+    HAL_GPIO_DeInit(LEAD2_GPIO_Port, LEAD2_Pin);
+#endif
+#if LEAD_COUNT > 2
+    HAL_GPIO_DeInit(LEAD3_GPIO_Port, LEAD3_Pin);
+#endif
+
   /* USER CODE END ADC1_MspDeInit 1 */
   }
 
@@ -464,7 +482,18 @@ void HAL_SPI_MspDeInit(SPI_HandleTypeDef* hspi)
 */
 void HAL_TIM_Base_MspInit(TIM_HandleTypeDef* htim_base)
 {
-  if(htim_base->Instance==TIM7)
+  if(htim_base->Instance==TIM6)
+  {
+  /* USER CODE BEGIN TIM6_MspInit 0 */
+
+  /* USER CODE END TIM6_MspInit 0 */
+    /* Peripheral clock enable */
+    __HAL_RCC_TIM6_CLK_ENABLE();
+  /* USER CODE BEGIN TIM6_MspInit 1 */
+
+  /* USER CODE END TIM6_MspInit 1 */
+  }
+  else if(htim_base->Instance==TIM7)
   {
   /* USER CODE BEGIN TIM7_MspInit 0 */
 
@@ -503,7 +532,18 @@ void HAL_TIM_Base_MspInit(TIM_HandleTypeDef* htim_base)
 */
 void HAL_TIM_Base_MspDeInit(TIM_HandleTypeDef* htim_base)
 {
-  if(htim_base->Instance==TIM7)
+  if(htim_base->Instance==TIM6)
+  {
+  /* USER CODE BEGIN TIM6_MspDeInit 0 */
+
+  /* USER CODE END TIM6_MspDeInit 0 */
+    /* Peripheral clock disable */
+    __HAL_RCC_TIM6_CLK_DISABLE();
+  /* USER CODE BEGIN TIM6_MspDeInit 1 */
+
+  /* USER CODE END TIM6_MspDeInit 1 */
+  }
+  else if(htim_base->Instance==TIM7)
   {
   /* USER CODE BEGIN TIM7_MspDeInit 0 */
 
@@ -271,6 +271,21 @@ void TIM1_UP_TIM16_IRQHandler(void)
   /* USER CODE END TIM1_UP_TIM16_IRQn 1 */
 }
 
+/**
+  * @brief This function handles EXTI line[15:10] interrupts.
+  */
+void EXTI15_10_IRQHandler(void)
+{
+  /* USER CODE BEGIN EXTI15_10_IRQn 0 */
+
+  /* USER CODE END EXTI15_10_IRQn 0 */
+  HAL_GPIO_EXTI_IRQHandler(LODP_Pin);
+  HAL_GPIO_EXTI_IRQHandler(LODN_Pin);
+  /* USER CODE BEGIN EXTI15_10_IRQn 1 */
+  handle_lead_off_change();
+  /* USER CODE END EXTI15_10_IRQn 1 */
+}
+
 /**
   * @brief This function handles TIM7 global interrupt.
   */
@@ -0,0 +1,76 @@
+/*
+ * stm32l4xx.h
+ *
+ * Host stand-in for the CMSIS device header. The peripherals the display
+ * driver touches are plain structs in memory, the instances are defined by
+ * Tools/ili9341_host. Only what Core/ uses is here, with the values of the
+ * target.
+ */
+
+#ifndef HOST_STM32L4XX_H_
+#define HOST_STM32L4XX_H_
+
+#include <stdint.h>
+
+#define __IO volatile
+
+typedef struct {
+  __IO uint32_t IDR;
+  __IO uint32_t ODR;
+  __IO uint32_t BSRR;
+  __IO uint32_t BRR;
+} GPIO_TypeDef;
+
+typedef struct {
+  __IO uint32_t CR1;
+  __IO uint32_t CR2;
+  __IO uint32_t SR;
+  __IO uint32_t DR;
+} SPI_TypeDef;
+
+typedef struct {
+  __IO uint32_t CCR;
+  __IO uint32_t CNDTR;
+  __IO uint32_t CPAR;
+  __IO uint32_t CMAR;
+} DMA_Channel_TypeDef;
+
+typedef struct {
+  __IO uint32_t CR1;
+} TIM_TypeDef;
+
+extern GPIO_TypeDef host_gpioa, host_gpiob;
+extern SPI_TypeDef host_spi1;
+extern DMA_Channel_TypeDef host_dma1_channel3;
+extern TIM_TypeDef host_tim7, host_tim16;
+
+#define GPIOA (&host_gpioa)
+#define GPIOB (&host_gpiob)
+#define SPI1 (&host_spi1)
+#define DMA1_Channel3 (&host_dma1_channel3)
+#define TIM7 (&host_tim7)
+#define TIM16 (&host_tim16)
+
+#define SPI_CR1_BR (0x7U << 3)
+#define SPI_CR1_SPE (0x1U << 6)
+#define SPI_CR2_DS (0xFU << 8)
+#define SPI_CR2_FRXTH (0x1U << 12)
+
+#define DMA_CCR_MINC (0x1U << 7)
+#define DMA_CCR_PSIZE (0x3U << 8)
+#define DMA_CCR_MSIZE (0x3U << 10)
+
+// Host pointers never fall in these, so the driver's SRAM2 alias is not taken.
+#define SRAM1_BASE 0x20000000UL
+#define SRAM1_SIZE_MAX 0x0000C000UL
+#define SRAM2_BASE 0x10000000UL
+#define SRAM2_SIZE 0x00004000UL
+
+#define SET_BIT(REG, BIT) ((REG) |= (BIT))
+#define CLEAR_BIT(REG, BIT) ((REG) &= ~(BIT))
+#define READ_BIT(REG, BIT) ((REG) & (BIT))
+#define WRITE_REG(REG, VAL) ((REG) = (VAL))
+#define READ_REG(REG) ((REG))
+#define MODIFY_REG(REG, CLEARMASK, SETMASK) WRITE_REG((REG), (((READ_REG(REG)) & (~(CLEARMASK))) | (SETMASK)))
+
+#endif /* HOST_STM32L4XX_H_ */
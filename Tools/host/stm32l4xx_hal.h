@@ -0,0 +1,139 @@
+/*
+ * stm32l4xx_hal.h
+ *
+ * Host stand-in for the STM32 HAL umbrella header. It lets the hardware
+ * independent modules of Core/ be compiled and exercised on a PC by the
+ * tools in this directory.
+ *
+ * The handles and functions below are the part of the HAL the display code
+ * uses. They are only implemented by Tools/ili9341_host, which runs the
+ * driver against a model of the panel; the other tools just don't call them.
+ */
+
+#ifndef HOST_STM32L4XX_HAL_H_
+#define HOST_STM32L4XX_HAL_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "stm32l4xx.h"
+#include "stm32l4xx_hal_def.h"
+
+// GPIO
+
+typedef enum {
+  GPIO_PIN_RESET = 0,
+  GPIO_PIN_SET
+} GPIO_PinState;
+
+#define GPIO_PIN_0 ((uint16_t) 0x0001)
+#define GPIO_PIN_1 ((uint16_t) 0x0002)
+#define GPIO_PIN_2 ((uint16_t) 0x0004)
+#define GPIO_PIN_3 ((uint16_t) 0x0008)
+#define GPIO_PIN_4 ((uint16_t) 0x0010)
+#define GPIO_PIN_5 ((uint16_t) 0x0020)
+#define GPIO_PIN_6 ((uint16_t) 0x0040)
+#define GPIO_PIN_7 ((uint16_t) 0x0080)
+#define GPIO_PIN_8 ((uint16_t) 0x0100)
+#define GPIO_PIN_9 ((uint16_t) 0x0200)
+#define GPIO_PIN_10 ((uint16_t) 0x0400)
+#define GPIO_PIN_11 ((uint16_t) 0x0800)
+#define GPIO_PIN_12 ((uint16_t) 0x1000)
+#define GPIO_PIN_13 ((uint16_t) 0x2000)
+#define GPIO_PIN_14 ((uint16_t) 0x4000)
+#define GPIO_PIN_15 ((uint16_t) 0x8000)
+
+#define IS_GPIO_PIN(PIN) ((((uint32_t) (PIN)) & 0xFFFFU) != 0x00U)
+
+void HAL_GPIO_WritePin(GPIO_TypeDef* GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState);
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef* GPIOx, uint16_t GPIO_Pin);
+
+// DMA
+
+typedef enum {
+  HAL_DMA_STATE_RESET = 0x00,
+  HAL_DMA_STATE_READY = 0x01,
+  HAL_DMA_STATE_BUSY = 0x02,
+  HAL_DMA_STATE_TIMEOUT = 0x03
+} HAL_DMA_StateTypeDef;
+
+#define DMA_MINC_ENABLE DMA_CCR_MINC
+#define DMA_MINC_DISABLE 0x00000000U
+#define DMA_PDATAALIGN_BYTE 0x00000000U
+#define DMA_PDATAALIGN_HALFWORD (0x1U << 8)
+#define DMA_MDATAALIGN_BYTE 0x00000000U
+#define DMA_MDATAALIGN_HALFWORD (0x1U << 10)
+
+typedef struct {
+  uint32_t MemInc;
+  uint32_t PeriphDataAlignment;
+  uint32_t MemDataAlignment;
+} DMA_InitTypeDef;
+
+typedef struct {
+  DMA_Channel_TypeDef* Instance;
+  DMA_InitTypeDef Init;
+  __IO HAL_DMA_StateTypeDef State;
+} DMA_HandleTypeDef;
+
+HAL_DMA_StateTypeDef HAL_DMA_GetState(DMA_HandleTypeDef* hdma);
+
+// SPI
+
+#define SPI_DATASIZE_8BIT 0x00000700U
+#define SPI_DATASIZE_16BIT 0x00000F00U
+#define SPI_RXFIFO_THRESHOLD_QF SPI_CR2_FRXTH
+#define SPI_BAUDRATEPRESCALER_2 0x00000000U
+#define SPI_BAUDRATEPRESCALER_8 0x00000010U
+#define SPI_BAUDRATEPRESCALER_128 0x00000030U
+
+typedef struct {
+  uint32_t DataSize;
+  uint32_t BaudRatePrescaler;
+} SPI_InitTypeDef;
+
+typedef struct __SPI_HandleTypeDef {
+  SPI_TypeDef* Instance;
+  SPI_InitTypeDef Init;
+  DMA_HandleTypeDef* hdmatx;
+} SPI_HandleTypeDef;
+
+HAL_StatusTypeDef HAL_SPI_Transmit(SPI_HandleTypeDef* hspi, uint8_t* pData, uint16_t Size, uint32_t Timeout);
+HAL_StatusTypeDef HAL_SPI_TransmitReceive(SPI_HandleTypeDef* hspi, uint8_t* pTxData, uint8_t* pRxData, uint16_t Size,
+    uint32_t Timeout);
+HAL_StatusTypeDef HAL_SPI_Transmit_DMA(SPI_HandleTypeDef* hspi, uint8_t* pData, uint16_t Size);
+void HAL_SPI_TxCpltCallback(SPI_HandleTypeDef* hspi);
+
+// Timers, ADC, DAC and CRC, only as far as the application starts and stops them
+
+typedef struct {
+  TIM_TypeDef* Instance;
+} TIM_HandleTypeDef;
+
+typedef struct {
+  uint32_t Instance;
+} ADC_HandleTypeDef;
+
+typedef struct {
+  uint32_t Instance;
+} DAC_HandleTypeDef;
+
+typedef struct {
+  uint32_t Instance;
+} CRC_HandleTypeDef;
+
+#define DAC_CHANNEL_1 0x00000000U
+#define DAC_ALIGN_8B_R 0x00000008U
+
+HAL_StatusTypeDef HAL_TIM_Base_Stop_IT(TIM_HandleTypeDef* htim);
+HAL_StatusTypeDef HAL_ADC_Start_DMA(ADC_HandleTypeDef* hadc, uint32_t* pData, uint32_t Length);
+HAL_StatusTypeDef HAL_DAC_Start(DAC_HandleTypeDef* hdac, uint32_t Channel);
+HAL_StatusTypeDef HAL_DAC_SetValue(DAC_HandleTypeDef* hdac, uint32_t Channel, uint32_t Alignment, uint32_t Data);
+
+// System
+
+uint32_t HAL_GetTick(void);
+void HAL_Delay(uint32_t Delay);
+
+#endif /* HOST_STM32L4XX_HAL_H_ */
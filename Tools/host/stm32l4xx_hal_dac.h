@@ -0,0 +1,13 @@
+/*
+ * stm32l4xx_hal_dac.h
+ *
+ * Host stand-in for the DAC driver header, the DAC is declared with the rest
+ * of the HAL in stm32l4xx_hal.h.
+ */
+
+#ifndef HOST_STM32L4XX_HAL_DAC_H_
+#define HOST_STM32L4XX_HAL_DAC_H_
+
+#include "stm32l4xx_hal.h"
+
+#endif /* HOST_STM32L4XX_HAL_DAC_H_ */
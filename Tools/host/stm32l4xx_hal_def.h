@@ -0,0 +1,30 @@
+/*
+ * stm32l4xx_hal_def.h
+ *
+ * Host stand-in for the common HAL definitions.
+ */
+
+#ifndef HOST_STM32L4XX_HAL_DEF_H_
+#define HOST_STM32L4XX_HAL_DEF_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "stm32l4xx.h"
+
+typedef enum {
+  HAL_OK = 0x00,
+  HAL_ERROR = 0x01,
+  HAL_BUSY = 0x02,
+  HAL_TIMEOUT = 0x03
+} HAL_StatusTypeDef;
+
+#define HAL_MAX_DELAY 0xFFFFFFFFU
+
+#define UNUSED(X) (void) X
+
+#ifndef __weak
+#define __weak __attribute__((weak))
+#endif
+
+#endif /* HOST_STM32L4XX_HAL_DEF_H_ */
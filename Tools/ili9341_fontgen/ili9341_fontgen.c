@@ -0,0 +1,250 @@
+/*
+ * ili9341_fontgen.c
+ *
+ * Host tool that generates Core/Src/ili9341_font_aa.c, the anti-aliased
+ * numerals of the pulse readout (see ili9341_aa_font_t).
+ *
+ * The glyphs are drawn with strokes, lines and elliptic arcs, in design units.
+ * Every pixel is sampled at SUPERSAMPLE x SUPERSAMPLE points, and the share of
+ * them inside a stroke is kept as 2 bits of coverage. The pixels of a glyph are
+ * then run-length encoded in raster order, a run in a byte.
+ *
+ *   make font          rewrites the font source
+ *   ./ili9341_fontgen -p  shows the glyphs on stderr instead
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#define FONT_NAME "ili9341_font_aa_22x36"
+#define FONT_CHARS " -0123456789"
+
+#define GLYPH_WIDTH 22
+#define GLYPH_HEIGHT 36
+
+#define DESIGN_WIDTH 100.0  // the strokes are given in a box of this size, the origin top left
+#define DESIGN_HEIGHT 164.0
+#define STROKE_RADIUS 9.0   // half the width of a stroke, in design units
+
+#define SUPERSAMPLE 4
+#define LEVEL_MAX 3         // 2 bits of coverage
+#define RUN_MAX 64          // 6 bits of run length
+
+#define ARC_STEPS 96        // line segments of a full turn
+#define MAX_SEGMENTS 512
+
+#define PI 3.14159265358979323846
+
+typedef struct {
+  double x0, y0, x1, y1;
+} segment_t;
+
+static segment_t segments[MAX_SEGMENTS];
+static int segment_count;
+
+static void line(double x0, double y0, double x1, double y1) {
+  if (segment_count == MAX_SEGMENTS) {
+    fprintf(stderr, "too many segments\n");
+    exit(1);
+  }
+  segments[segment_count++] = (segment_t) { x0, y0, x1, y1 };
+}
+
+// An arc of the ellipse around (cx, cy) from angle from to angle to, in degrees. The angles turn counterclockwise
+// as seen on the screen, 0 is to the right.
+static void arc(double cx, double cy, double rx, double ry, double from, double to) {
+  int steps = (int) ceil(fabs(to - from) / 360 * ARC_STEPS);
+  double px = cx + rx * cos(from * PI / 180), py = cy - ry * sin(from * PI / 180);
+  for (int i = 1; i <= steps; i++) {
+    double angle = (from + (to - from) * i / steps) * PI / 180;
+    double x = cx + rx * cos(angle), y = cy - ry * sin(angle);
+    line(px, py, x, y);
+    px = x;
+    py = y;
+  }
+}
+
+static void ellipse(double cx, double cy, double rx, double ry) {
+  arc(cx, cy, rx, ry, 0, 360);
+}
+
+static void draw_glyph(char ch) {
+  segment_count = 0;
+  switch (ch) {
+    case '-':
+      line(28, 82, 72, 82);
+      break;
+    case '0':
+      ellipse(50, 82, 32, 66);
+      break;
+    case '1':
+      line(50, 16, 50, 148);
+      line(30, 36, 50, 16);
+      break;
+    case '2':
+      arc(50, 48, 32, 32, 160, -30);
+      line(50 + 32 * cos(-30 * PI / 180), 48 + 32 * sin(30 * PI / 180), 18, 148);
+      line(18, 148, 82, 148);
+      break;
+    case '3':
+      arc(50, 49, 31, 33, 150, -90);
+      arc(50, 115, 32, 33, 90, -150);
+      break;
+    case '4':
+      line(64, 148, 64, 16);
+      line(64, 16, 18, 112);
+      line(18, 112, 84, 112);
+      break;
+    case '5':
+      line(78, 16, 26, 16);
+      line(26, 16, 24, 80);
+      arc(48, 108, 33, 40, 135, -150);
+      break;
+    case '6':
+      ellipse(50, 108, 32, 40);
+      arc(82, 108, 64, 92, 100, 180);
+      break;
+    case '7':
+      line(18, 16, 82, 16);
+      line(82, 16, 38, 148);
+      break;
+    case '8':
+      ellipse(50, 48, 28, 32);
+      ellipse(50, 114, 32, 34);
+      break;
+    case '9':
+      ellipse(50, 56, 32, 40);
+      arc(18, 56, 64, 92, -80, 0);
+      break;
+    default:
+      break;
+  }
+}
+
+static double distance_squared(const segment_t* s, double x, double y) {
+  double dx = s->x1 - s->x0, dy = s->y1 - s->y0;
+  double length = dx * dx + dy * dy;
+  double t = length > 0 ? ((x - s->x0) * dx + (y - s->y0) * dy) / length : 0;
+  if (t < 0) {
+    t = 0;
+  }
+  else if (t > 1) {
+    t = 1;
+  }
+  double ex = s->x0 + t * dx - x, ey = s->y0 + t * dy - y;
+  return ex * ex + ey * ey;
+}
+
+static int is_inked(double x, double y) {
+  for (int i = 0; i < segment_count; i++) {
+    if (distance_squared(&segments[i], x, y) <= STROKE_RADIUS * STROKE_RADIUS) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+static void rasterize(unsigned char levels[GLYPH_HEIGHT][GLYPH_WIDTH]) {
+  for (int y = 0; y < GLYPH_HEIGHT; y++) {
+    for (int x = 0; x < GLYPH_WIDTH; x++) {
+      int inked = 0;
+      for (int sy = 0; sy < SUPERSAMPLE; sy++) {
+        for (int sx = 0; sx < SUPERSAMPLE; sx++) {
+          double u = (x + (sx + 0.5) / SUPERSAMPLE) * DESIGN_WIDTH / GLYPH_WIDTH;
+          double v = (y + (sy + 0.5) / SUPERSAMPLE) * DESIGN_HEIGHT / GLYPH_HEIGHT;
+          inked += is_inked(u, v);
+        }
+      }
+      levels[y][x] = (inked * LEVEL_MAX + SUPERSAMPLE * SUPERSAMPLE / 2) / (SUPERSAMPLE * SUPERSAMPLE);
+    }
+  }
+}
+
+// Encodes the glyph into runs, returns their number.
+static int encode(unsigned char levels[GLYPH_HEIGHT][GLYPH_WIDTH], unsigned char* runs) {
+  const unsigned char* pixels = &levels[0][0];
+  int count = 0;
+  for (int i = 0; i < GLYPH_WIDTH * GLYPH_HEIGHT;) {
+    int length = 1;
+    while (length < RUN_MAX && i + length < GLYPH_WIDTH * GLYPH_HEIGHT && pixels[i + length] == pixels[i]) {
+      length++;
+    }
+    runs[count++] = (unsigned char) (pixels[i] << 6 | (length - 1));
+    i += length;
+  }
+  return count;
+}
+
+static void preview(char ch, unsigned char levels[GLYPH_HEIGHT][GLYPH_WIDTH]) {
+  static const char SHADES[] = " .+#";
+  fprintf(stderr, "'%c'\n", ch);
+  for (int y = 0; y < GLYPH_HEIGHT; y++) {
+    for (int x = 0; x < GLYPH_WIDTH; x++) {
+      fputc(SHADES[levels[y][x]], stderr);
+    }
+    fputc('\n', stderr);
+  }
+}
+
+int main(int argc, char** argv) {
+  int show = argc > 1 && strcmp(argv[1], "-p") == 0;
+  const char* chars = FONT_CHARS;
+  int glyph_count = strlen(chars);
+  unsigned char levels[GLYPH_HEIGHT][GLYPH_WIDTH];
+  unsigned char runs[GLYPH_WIDTH * GLYPH_HEIGHT];
+  int offsets[sizeof(FONT_CHARS)];
+
+  if (!show) {
+    printf("/*\n"
+           " * ili9341_font_aa.c\n"
+           " *\n"
+           " * Generated by Tools/ili9341_fontgen, do not edit.\n"
+           " */\n\n"
+           "// ----------------------------------------------------------------- includes --\n\n"
+           "#include \"ili9341_font.h\"\n\n"
+           "// ------------------------------------------------------- private variables --\n\n"
+           "static uint8_t const %s_data[] = {\n", FONT_NAME);
+  }
+  int total = 0;
+  for (int g = 0; g < glyph_count; g++) {
+    draw_glyph(chars[g]);
+    rasterize(levels);
+    if (show) {
+      preview(chars[g], levels);
+      continue;
+    }
+    int count = encode(levels, runs);
+    offsets[g] = total;
+    total += count;
+    printf("  // '%c'\n", chars[g]);
+    for (int i = 0; i < count; i++) {
+      printf("%s0x%02X,%s", i % 12 == 0 ? "  " : " ", runs[i], i % 12 == 11 || i == count - 1 ? "\n" : "");
+    }
+  }
+  if (show) {
+    return 0;
+  }
+  offsets[glyph_count] = total;
+  printf("};\n\n"
+         "static uint16_t const %s_offset[] = {\n ", FONT_NAME);
+  for (int g = 0; g <= glyph_count; g++) {
+    printf(" %d,", offsets[g]);
+  }
+  printf("\n};\n\n"
+         "// ------------------------------------------------------- exported variables --\n\n"
+         "ili9341_aa_font_t const %s = {\n"
+         "  .width  = %d,\n"
+         "  .height = %d,\n"
+         "  .chars  = \"%s\",\n"
+         "  .offset = %s_offset,\n"
+         "  .data   = %s_data,\n"
+         "};\n", FONT_NAME, GLYPH_WIDTH, GLYPH_HEIGHT, chars, FONT_NAME, FONT_NAME);
+
+  fprintf(stderr, "%d glyphs of %dx%d: %d bytes of runs, %d bytes of offsets (%d bytes as 2 bit pixels)\n",
+      glyph_count, GLYPH_WIDTH, GLYPH_HEIGHT, total, (int) ((glyph_count + 1) * sizeof(uint16_t)),
+      glyph_count * GLYPH_WIDTH * GLYPH_HEIGHT / 4);
+  return 0;
+}
@@ -0,0 +1,124 @@
+/*
+ * hal_host.c
+ *
+ * The HAL functions used by the display code, on a PC. The GPIO writes and the
+ * SPI transfers go to the model of ili9341_host.c. A DMA transfer is done at
+ * once, and completes (HAL_SPI_TxCpltCallback) before it returns, so the DMA
+ * is never busy when the driver looks. The tick only moves when the caller
+ * moves it.
+ */
+
+#include <string.h>
+
+#include "stm32l4xx_hal.h"
+#include "ili9341_host.h"
+
+GPIO_TypeDef host_gpioa = { .IDR = 0xFFFF }, host_gpiob = { .IDR = 0xFFFF }; // the inputs are pulled up
+
+SPI_TypeDef host_spi1;
+
+DMA_Channel_TypeDef host_dma1_channel3;
+
+TIM_TypeDef host_tim7, host_tim16;
+
+static uint32_t tick = 0;
+
+static uint16_t* adc_buffer = NULL;
+
+static uint32_t adc_length = 0;
+
+static void spi_transfer(SPI_HandleTypeDef* hspi, const uint8_t* data, uint16_t size, bool increment) {
+  if (hspi->Init.DataSize == SPI_DATASIZE_16BIT) {
+    ili9341_host_transfer_words((const uint16_t*) data, size, increment);
+  }
+  else {
+    ili9341_host_transfer_bytes(data, size, increment);
+  }
+}
+
+void HAL_GPIO_WritePin(GPIO_TypeDef* GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState) {
+  if (PinState == GPIO_PIN_SET) {
+    GPIOx->ODR |= GPIO_Pin;
+  }
+  else {
+    GPIOx->ODR &= ~(uint32_t) GPIO_Pin;
+  }
+  ili9341_host_pin(GPIOx, GPIO_Pin, PinState == GPIO_PIN_SET);
+}
+
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef* GPIOx, uint16_t GPIO_Pin) {
+  return (GPIOx->IDR & GPIO_Pin) != 0 ? GPIO_PIN_SET : GPIO_PIN_RESET;
+}
+
+HAL_DMA_StateTypeDef HAL_DMA_GetState(DMA_HandleTypeDef* hdma) {
+  return hdma->State;
+}
+
+HAL_StatusTypeDef HAL_SPI_Transmit(SPI_HandleTypeDef* hspi, uint8_t* pData, uint16_t Size, uint32_t Timeout) {
+  UNUSED(Timeout);
+  spi_transfer(hspi, pData, Size, true);
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_SPI_TransmitReceive(SPI_HandleTypeDef* hspi, uint8_t* pTxData, uint8_t* pRxData, uint16_t Size,
+    uint32_t Timeout) {
+  UNUSED(Timeout);
+  spi_transfer(hspi, pTxData, Size, true);
+  // Nothing answers, the bus reads as 0.
+  memset(pRxData, 0, hspi->Init.DataSize == SPI_DATASIZE_16BIT ? 2 * (size_t) Size : Size);
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_SPI_Transmit_DMA(SPI_HandleTypeDef* hspi, uint8_t* pData, uint16_t Size) {
+  spi_transfer(hspi, pData, Size, hspi->hdmatx->Init.MemInc == DMA_MINC_ENABLE);
+  HAL_SPI_TxCpltCallback(hspi);
+  return HAL_OK;
+}
+
+__weak void HAL_SPI_TxCpltCallback(SPI_HandleTypeDef* hspi) {
+  UNUSED(hspi);
+}
+
+HAL_StatusTypeDef HAL_TIM_Base_Stop_IT(TIM_HandleTypeDef* htim) {
+  UNUSED(htim);
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_ADC_Start_DMA(ADC_HandleTypeDef* hadc, uint32_t* pData, uint32_t Length) {
+  UNUSED(hadc);
+  // The ADC DMA moves halfwords, the HAL takes the buffer as words anyway.
+  adc_buffer = (uint16_t*) pData;
+  adc_length = Length;
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_DAC_Start(DAC_HandleTypeDef* hdac, uint32_t Channel) {
+  UNUSED(hdac);
+  UNUSED(Channel);
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_DAC_SetValue(DAC_HandleTypeDef* hdac, uint32_t Channel, uint32_t Alignment, uint32_t Data) {
+  UNUSED(hdac);
+  UNUSED(Channel);
+  UNUSED(Alignment);
+  UNUSED(Data);
+  return HAL_OK;
+}
+
+uint32_t HAL_GetTick(void) {
+  return tick;
+}
+
+void HAL_Delay(uint32_t Delay) {
+  tick += Delay;
+}
+
+void hal_host_advance(uint32_t ms) {
+  tick += ms;
+}
+
+uint16_t* hal_host_adc_buffer(uint32_t* length) {
+  *length = adc_length;
+  return adc_buffer;
+}
@@ -0,0 +1,390 @@
+/*
+ * ili9341_bench.c
+ *
+ * Host benchmark of the graphics layer, on the back-end of ili9341_host.c. The
+ * application (Core/Src/display.c) is brought up as on the board, with a
+ * synthetic ECG fed through the ADC buffer, and then each benchmark draws on
+ * its LCD: the primitives of ili9341_gfx.c, and sweeps of the trace by
+ * display_graph() in both layouts. For each one the traffic on the SPI bus is
+ * counted, with its modelled time on the wire, and the screen it leaves behind
+ * is summed up in a checksum.
+ *
+ *   make && ./ili9341_bench          prints the table
+ *   ./ili9341_bench -o shots         also writes the screens, shots/<benchmark>.ppm
+ *   ./ili9341_bench -r before.txt    compares with an earlier table, fails if the
+ *                                    traffic grew or an image changed
+ *   -c <hz> -t <ns>                  the SPI clock, and a fixed cost per transaction
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <math.h>
+
+#include "main.h"
+#include "ili9341_gfx.h"
+#include "signal_processing.h"
+#include "settings.h"
+#include "ad_header.h"
+#include "ili9341_host.h"
+
+#define DEFAULT_CLOCK_HZ 16000000 // SPI1 at SYSCLK / 2
+
+#define SAMPLE_PERIOD_MS 5        // 200 Hz, the sampling timer
+#define BRING_UP_SAMPLES 400      // the LCD is ready after 1.32 s
+#define SWEEP_SAMPLES 320         // a sample per column
+
+#define MAX_BENCHMARKS 16
+
+#define PI 3.14159265358979323846
+
+typedef struct {
+  const char* name;
+  void (*setup)(void);           // not measured
+  void (*run)(ili9341_t* lcd);   // draws on the LCD, or
+  uint32_t display_samples;      // runs the display for this many samples
+} benchmark_t;
+
+typedef struct {
+  char name[64];
+  ili9341_host_stats_t stats;
+  uint32_t checksum;
+} result_t;
+
+extern ili9341_t* ili9341_lcd; // display.c
+
+static SPI_HandleTypeDef hspi1;
+static DMA_HandleTypeDef hdma_spi1_tx;
+static TIM_HandleTypeDef htim16;
+static ADC_HandleTypeDef hadc1;
+static DAC_HandleTypeDef hdac1;
+
+static uint32_t sample_number = 0;
+
+// The application modules not taken to the host.
+
+void enableAD() {
+}
+
+void disableAD() {
+}
+
+bool settings_load_detector_state(pt_state_t* state) {
+  UNUSED(state);
+  return false;
+}
+
+bool settings_save_detector_state(const pt_state_t* state) {
+  UNUSED(state);
+  return true;
+}
+
+// A beat every 0.8 s (75 bpm): the P, Q, R, S and T waves as gaussians on the baseline, in 14 bit ADC units.
+static uint16_t ecg_sample(uint32_t n) {
+  static const struct {
+    double at, width, amplitude;
+  } WAVES[] = {
+    { 0.20, 0.025, 120 }, { 0.36, 0.010, -150 }, { 0.38, 0.010, 2000 }, { 0.40, 0.010, -400 }, { 0.62, 0.040, 320 }
+  };
+  double t = fmod(n * SAMPLE_PERIOD_MS / 1000.0, 0.8);
+  double value = ADC_MAX_VALUE / 2;
+  for (size_t i = 0; i < sizeof(WAVES) / sizeof(WAVES[0]); i++) {
+    double d = (t - WAVES[i].at) / WAVES[i].width;
+    value += WAVES[i].amplitude * exp(-d * d / 2);
+  }
+  return (uint16_t) lround(value);
+}
+
+// What the ADC DMA and the sampling timer do on the board.
+static void acquire_sample(void) {
+  uint32_t length;
+  uint16_t* buffer = hal_host_adc_buffer(&length);
+  uint16_t value = ecg_sample(sample_number++);
+  for (uint32_t i = 0; i < length; i++) {
+    buffer[i] = value;
+  }
+  hal_host_advance(SAMPLE_PERIOD_MS);
+  HAL_TIM_PeriodElapsedCallback(&htim16);
+}
+
+static void run_display(uint32_t samples) {
+  for (uint32_t i = 0; i < samples; i++) {
+    acquire_sample();
+    display_graph();
+  }
+}
+
+static void bench_fill_screen(ili9341_t* lcd) {
+  ili9341_fill_screen(lcd, ILI9341_NAVY);
+}
+
+static void bench_fill_rect_blocks(ili9341_t* lcd) {
+  uint8_t wheel = 0;
+  for (int16_t y = 0; y + 16 <= lcd->screen_size.height; y += 16) {
+    for (int16_t x = 0; x + 16 <= lcd->screen_size.width; x += 16) {
+      ili9341_fill_rect(lcd, ili9341_color_wheel(&wheel), x, y, 16, 16);
+    }
+  }
+}
+
+// The erase of a column of the trace.
+static void bench_fill_rect_columns(ili9341_t* lcd) {
+  for (int16_t x = 0; x < lcd->screen_size.width; x++) {
+    ili9341_fill_rect(lcd, x & 1 ? ILI9341_BLACK : ILI9341_DARKGREY, x, 50, 1, 110);
+  }
+}
+
+static void bench_draw_line_fan(ili9341_t* lcd) {
+  int16_t cx = lcd->screen_size.width / 2, cy = lcd->screen_size.height / 2;
+  uint8_t wheel = 0;
+  for (int angle = 0; angle < 360; angle += 5) {
+    int16_t x = cx + (int16_t) lround(110 * cos(angle * PI / 180));
+    int16_t y = cy - (int16_t) lround(110 * sin(angle * PI / 180));
+    ili9341_draw_line(lcd, ili9341_color_wheel(&wheel), cx, cy, x, y);
+  }
+  for (int16_t i = 0; i < 10; i++) {
+    ili9341_draw_line(lcd, ILI9341_WHITE, 0, 5 + i * 24, lcd->screen_size.width - 1, 5 + i * 24);
+    ili9341_draw_line(lcd, ILI9341_WHITE, 5 + i * 32, 0, 5 + i * 32, lcd->screen_size.height - 1);
+  }
+}
+
+// The segments of the sweep, between the samples of consecutive columns.
+static void bench_draw_line_trace(ili9341_t* lcd) {
+  uint16_t previous_y = 0;
+  for (int16_t x = 0; x < lcd->screen_size.width; x++) {
+    uint16_t y = 50 + (ecg_sample(x) - (ADC_MAX_VALUE / 2 - 800)) * 110 / 3200;
+    if (x > 0) {
+      ili9341_draw_line(lcd, ILI9341_GREEN, x - 1, previous_y, x, y);
+    }
+    previous_y = y;
+  }
+}
+
+static void draw_text(ili9341_t* lcd, ili9341_font_t const* font, ili9341_color_t fg_color,
+    ili9341_color_t bg_color, int16_t x, int16_t y, char* text) {
+  ili9341_text_attr_t attr = {
+    .font = font, .fg_color = fg_color, .bg_color = bg_color, .origin_x = x, .origin_y = y
+  };
+  ili9341_draw_string(lcd, attr, text);
+}
+
+static void bench_draw_string(ili9341_t* lcd) {
+  draw_text(lcd, &ili9341_font_16x26, ILI9341_LIGHTGREY, ILI9341_BLACK, 60, 100, "EKG MONITOR");
+  draw_text(lcd, &ili9341_font_11x18, ILI9341_LIGHTGREY, ILI9341_BLUE, 10, 10, "Halozat 50");
+  draw_text(lcd, &ili9341_font_11x18, ILI9341_LIGHTGREY, ILI9341_BLACK, 60, 40, "Nor"); // from the glyph cache
+  draw_text(lcd, &ili9341_font_7x10, ILI9341_LIGHTGREY, ILI9341_BLACK, 120, 150, "1.0");
+  draw_text(lcd, &ili9341_font_11x18, ILI9341_RED, ILI9341_BLACK, 10, 200, "Elektroda?\r\nLine 2");
+}
+
+static void bench_draw_aa_string(ili9341_t* lcd) {
+  ili9341_draw_aa_string(lcd, &ili9341_font_aa_22x36, ILI9341_LIGHTGREY, ILI9341_BLACK, 200, 12, "72 ");
+  ili9341_draw_aa_string(lcd, &ili9341_font_aa_22x36, ILI9341_LIGHTGREY, ILI9341_BLACK, 200, 60, "120");
+}
+
+// Opens the menu at its selected item, as the button does, and draws it.
+static void open_menu(void) {
+  display_handle_button_press();
+  run_display(1);
+}
+
+// Presses the button on the item, counted from the selected one as the rotary knob does.
+static void press_menu_item(int32_t steps) {
+  display_handle_rotary_change(steps);
+  display_handle_button_press();
+  run_display(1);
+}
+
+// After the menu the sweep erases the whole columns, so the sweep starts from the trace alone.
+static void select_sweep(void) {
+  open_menu();
+  press_menu_item(5); // from the pause to back
+  run_display(SWEEP_SAMPLES);
+}
+
+static void select_scroll(void) {
+  open_menu();
+  press_menu_item(5); // from back to the layout
+  press_menu_item(1); // back
+  run_display(SWEEP_SAMPLES);
+}
+
+static const benchmark_t BENCHMARKS[] = {
+  { "fill_screen", NULL, bench_fill_screen, 0 },
+  { "fill_rect_blocks", NULL, bench_fill_rect_blocks, 0 },
+  { "fill_rect_columns", NULL, bench_fill_rect_columns, 0 },
+  { "draw_line_fan", NULL, bench_draw_line_fan, 0 },
+  { "draw_line_trace", NULL, bench_draw_line_trace, 0 },
+  { "draw_string", NULL, bench_draw_string, 0 },
+  { "draw_aa_string", NULL, bench_draw_aa_string, 0 },
+  { "display_graph_sweep", select_sweep, NULL, 2 * SWEEP_SAMPLES },
+  { "display_graph_scroll", select_scroll, NULL, 2 * SWEEP_SAMPLES },
+};
+
+#define BENCHMARK_COUNT (sizeof(BENCHMARKS) / sizeof(BENCHMARKS[0]))
+
+static void print_result(FILE* out, const result_t* result) {
+  const ili9341_host_stats_t* s = &result->stats;
+  fprintf(out, "%-22s %9llu %8llu %7llu %7llu %7llu %8llu %6llu %11.1f  %08x\n", result->name,
+      (unsigned long long) s->bytes, (unsigned long long) s->transactions, (unsigned long long) s->cs_toggles,
+      (unsigned long long) s->dc_toggles, (unsigned long long) s->commands, (unsigned long long) s->pixels,
+      (unsigned long long) s->errors, s->wire_us, result->checksum);
+}
+
+static int read_reference(const char* path, result_t* results) {
+  FILE* file = fopen(path, "r");
+  if (file == NULL) {
+    return -1;
+  }
+  char line[256];
+  int count = 0;
+  while (count < MAX_BENCHMARKS && fgets(line, sizeof(line), file) != NULL) {
+    result_t* r = &results[count];
+    unsigned long long v[7];
+    if (line[0] == '#' || sscanf(line, "%63s %llu %llu %llu %llu %llu %llu %llu %lf %x", r->name, &v[0], &v[1],
+        &v[2], &v[3], &v[4], &v[5], &v[6], &r->stats.wire_us, &r->checksum) != 10) {
+      continue;
+    }
+    r->stats.bytes = v[0];
+    r->stats.transactions = v[1];
+    r->stats.cs_toggles = v[2];
+    r->stats.dc_toggles = v[3];
+    r->stats.commands = v[4];
+    r->stats.pixels = v[5];
+    r->stats.errors = v[6];
+    count++;
+  }
+  fclose(file);
+  return count;
+}
+
+static bool grew(const char* name, const char* what, double before, double after) {
+  if (after <= before) {
+    return false;
+  }
+  fprintf(stderr, "%s: %s %.1f -> %.1f (+%.1f%%)\n", name, what, before, after,
+      before > 0 ? 100 * (after - before) / before : 100);
+  return true;
+}
+
+// Reports what got worse than in the reference, returns the number of regressions.
+static int compare(const result_t* result, const result_t* reference, int reference_count) {
+  for (int i = 0; i < reference_count; i++) {
+    if (strcmp(reference[i].name, result->name) != 0) {
+      continue;
+    }
+    const ili9341_host_stats_t* a = &reference[i].stats;
+    const ili9341_host_stats_t* b = &result->stats;
+    int regressions = grew(result->name, "bytes", a->bytes, b->bytes) +
+        grew(result->name, "transactions", a->transactions, b->transactions) +
+        grew(result->name, "cs toggles", a->cs_toggles, b->cs_toggles) +
+        grew(result->name, "dc toggles", a->dc_toggles, b->dc_toggles) +
+        grew(result->name, "errors", a->errors, b->errors) +
+        grew(result->name, "wire us", a->wire_us, round(b->wire_us * 10) / 10); // as printed
+    if (reference[i].checksum != result->checksum) {
+      fprintf(stderr, "%s: the image changed\n", result->name);
+      regressions++;
+    }
+    return regressions;
+  }
+  fprintf(stderr, "%s: not in the reference\n", result->name);
+  return 0;
+}
+
+static void usage(const char* name) {
+  fprintf(stderr, "usage: %s [-c spi_hz] [-t transaction_ns] [-o screen_dir] [-r reference]\n", name);
+  exit(2);
+}
+
+int main(int argc, char** argv) {
+  uint32_t clock_hz = DEFAULT_CLOCK_HZ, transaction_ns = 0;
+  const char* screen_dir = NULL;
+  const char* reference_path = NULL;
+  int option;
+  while ((option = getopt(argc, argv, "c:t:o:r:")) != -1) {
+    switch (option) {
+      case 'c':
+        clock_hz = strtoul(optarg, NULL, 10);
+        break;
+      case 't':
+        transaction_ns = strtoul(optarg, NULL, 10);
+        break;
+      case 'o':
+        screen_dir = optarg;
+        break;
+      case 'r':
+        reference_path = optarg;
+        break;
+      default:
+        usage(argv[0]);
+    }
+  }
+  if (optind != argc || clock_hz == 0) {
+    usage(argv[0]);
+  }
+
+  result_t reference[MAX_BENCHMARKS];
+  int reference_count = 0;
+  if (reference_path != NULL && (reference_count = read_reference(reference_path, reference)) < 0) {
+    fprintf(stderr, "can't read %s\n", reference_path);
+    return 2;
+  }
+
+  ili9341_host_set_clock(clock_hz, transaction_ns);
+  ili9341_host_connect(TFT_CS_GPIO_Port, TFT_CS_Pin, TFT_DC_GPIO_Port, TFT_DC_Pin, TFT_RESET_GPIO_Port,
+      TFT_RESET_Pin);
+
+  hdma_spi1_tx.Instance = DMA1_Channel3;
+  hdma_spi1_tx.Init.MemInc = DMA_MINC_ENABLE;
+  hdma_spi1_tx.State = HAL_DMA_STATE_READY;
+  hspi1.Instance = SPI1;
+  hspi1.Init.DataSize = SPI_DATASIZE_8BIT;
+  hspi1.Init.BaudRatePrescaler = SPI_BAUDRATEPRESCALER_2;
+  hspi1.hdmatx = &hdma_spi1_tx;
+  htim16.Instance = TIM16;
+
+  init_display(&hspi1, &htim16, &hadc1, &hdac1);
+  run_display(BRING_UP_SAMPLES);
+  if (ili9341_lcd == NULL || ili9341_lcd->init_state != iisReady) {
+    fprintf(stderr, "the LCD didn't come up\n");
+    return 1;
+  }
+
+  printf("# SPI clock %u Hz, %u ns per transaction\n", clock_hz, transaction_ns);
+  printf("# %-20s %9s %8s %7s %7s %7s %8s %6s %11s  %s\n", "benchmark", "bytes", "trans", "cs", "dc", "cmds",
+      "pixels", "errors", "wire_us", "checksum");
+  int regressions = 0;
+  for (size_t i = 0; i < BENCHMARK_COUNT; i++) {
+    const benchmark_t* benchmark = &BENCHMARKS[i];
+    if (benchmark->setup != NULL) {
+      benchmark->setup();
+    }
+    ili9341_host_reset_stats();
+    if (benchmark->run != NULL) {
+      benchmark->run(ili9341_lcd);
+    }
+    else {
+      run_display(benchmark->display_samples);
+    }
+
+    result_t result;
+    snprintf(result.name, sizeof(result.name), "%s", benchmark->name);
+    ili9341_host_get_stats(&result.stats);
+    result.checksum = ili9341_host_checksum();
+    print_result(stdout, &result);
+
+    if (screen_dir != NULL) {
+      char path[512];
+      snprintf(path, sizeof(path), "%s/%s.ppm", screen_dir, benchmark->name);
+      if (!ili9341_host_write_ppm(path)) {
+        fprintf(stderr, "can't write %s\n", path);
+      }
+    }
+    if (reference_path != NULL) {
+      regressions += compare(&result, reference, reference_count);
+    }
+  }
+  return regressions > 0 ? 1 : 0;
+}
@@ -0,0 +1,305 @@
+/*
+ * ili9341_host.c
+ *
+ * Model of the ILI9341 on its 4-wire SPI interface, as far as the driver uses
+ * it. The bytes received while the TFT is selected are commands (D/C low) or
+ * their parameters and the pixel data of a memory write (D/C high).
+ *
+ * The frame memory is kept in the panel's own layout, 240 columns by 320 lines.
+ * The address window of the driver is in logical coordinates, the memory access
+ * control (MADCTL) maps them onto the memory: MV exchanges the column and the
+ * line, then MX mirrors the column and MY the line. The vertical scrolling
+ * (VSCRDEF, VSCRSADD) works on the memory lines, and only changes which line is
+ * shown where, so the screen is read back through the scroll first and the
+ * mapping after it.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "ili9341_host.h"
+
+#define CMD_SWRESET 0x01
+#define CMD_CASET 0x2A
+#define CMD_PASET 0x2B
+#define CMD_RAMWR 0x2C
+#define CMD_VSCRDEF 0x33
+#define CMD_MADCTL 0x36
+#define CMD_VSCRSADD 0x37
+
+#define MADCTL_MY 0x80
+#define MADCTL_MX 0x40
+#define MADCTL_MV 0x20
+
+#define PARAMETER_MAX 16
+
+typedef struct {
+  GPIO_TypeDef* port;
+  uint16_t pin;
+} host_pin_t;
+
+static uint16_t memory[ILI9341_HOST_HEIGHT][ILI9341_HOST_WIDTH];
+
+static host_pin_t cs, dc, reset;
+
+static bool selected = false, data_mode = false;
+
+static uint8_t command, parameters[PARAMETER_MAX], parameter_count;
+
+// Within a memory write, the next pixel goes to (column, page) of the window. A pixel is two bytes, the MSB first.
+static bool writing = false, half_pixel = false;
+static uint8_t pixel_msb;
+
+static uint8_t madctl;
+
+static uint16_t column_start, column_end, page_start, page_end, column, page;
+
+static uint16_t scroll_top, scroll_size, scroll_start;
+
+static uint32_t clock_hz = 16000000, transaction_ns = 0;
+
+static ili9341_host_stats_t stats;
+
+static void reset_controller(void) {
+  // The frame memory keeps its content, as on the panel.
+  madctl = 0;
+  column_start = 0;
+  column_end = ILI9341_HOST_WIDTH - 1;
+  page_start = 0;
+  page_end = ILI9341_HOST_HEIGHT - 1;
+  scroll_top = 0;
+  scroll_size = ILI9341_HOST_HEIGHT;
+  scroll_start = 0;
+  writing = false;
+  half_pixel = false;
+}
+
+// Maps a logical address to the frame memory, false if it is outside of it.
+static bool map_address(uint16_t x, uint16_t y, uint16_t* memory_column, uint16_t* memory_line) {
+  uint16_t c = x, l = y;
+  if (madctl & MADCTL_MV) {
+    c = y;
+    l = x;
+  }
+  if (c >= ILI9341_HOST_WIDTH || l >= ILI9341_HOST_HEIGHT) {
+    return false;
+  }
+  *memory_column = madctl & MADCTL_MX ? ILI9341_HOST_WIDTH - 1 - c : c;
+  *memory_line = madctl & MADCTL_MY ? ILI9341_HOST_HEIGHT - 1 - l : l;
+  return true;
+}
+
+// The memory line shown on the panel at the position of line.
+static uint16_t scrolled_line(uint16_t line) {
+  if (scroll_size == 0 || line < scroll_top || line >= scroll_top + scroll_size ||
+      scroll_start < scroll_top || scroll_start >= scroll_top + scroll_size) {
+    return line;
+  }
+  return scroll_top + (line - scroll_top + scroll_start - scroll_top) % scroll_size;
+}
+
+static void write_pixel(uint16_t color) {
+  uint16_t memory_column, memory_line;
+  if (map_address(column, page, &memory_column, &memory_line)) {
+    memory[memory_line][memory_column] = color;
+    stats.pixels++;
+  }
+  if (column < column_end) {
+    column++;
+  }
+  else {
+    column = column_start;
+    page = page < page_end ? page + 1 : page_start;
+  }
+}
+
+static uint16_t parameter_word(uint8_t index) {
+  return (uint16_t) (parameters[index] << 8 | parameters[index + 1]);
+}
+
+static void apply_parameters(void) {
+  switch (command) {
+    case CMD_CASET:
+      if (parameter_count == 4) {
+        column_start = parameter_word(0);
+        column_end = parameter_word(2);
+      }
+      break;
+    case CMD_PASET:
+      if (parameter_count == 4) {
+        page_start = parameter_word(0);
+        page_end = parameter_word(2);
+      }
+      break;
+    case CMD_MADCTL:
+      if (parameter_count == 1) {
+        madctl = parameters[0];
+      }
+      break;
+    case CMD_VSCRDEF:
+      if (parameter_count == 6) {
+        scroll_top = parameter_word(0);
+        scroll_size = parameter_word(2);
+      }
+      break;
+    case CMD_VSCRSADD:
+      if (parameter_count == 2) {
+        scroll_start = parameter_word(0);
+      }
+      break;
+    default:
+      break;
+  }
+}
+
+static void receive(uint8_t byte) {
+  if (!selected) {
+    return;
+  }
+  if (!data_mode) {
+    if (half_pixel) {
+      stats.errors++;
+      half_pixel = false;
+    }
+    stats.commands++;
+    command = byte;
+    parameter_count = 0;
+    writing = command == CMD_RAMWR;
+    if (writing) {
+      column = column_start;
+      page = page_start;
+    }
+    else if (command == CMD_SWRESET) {
+      reset_controller();
+    }
+    return;
+  }
+  if (writing) {
+    if (half_pixel) {
+      write_pixel((uint16_t) (pixel_msb << 8 | byte));
+    }
+    else {
+      pixel_msb = byte;
+    }
+    half_pixel = !half_pixel;
+    return;
+  }
+  if (parameter_count < PARAMETER_MAX) {
+    parameters[parameter_count++] = byte;
+    apply_parameters();
+  }
+}
+
+static void count_transaction(uint64_t bytes) {
+  stats.transactions++;
+  stats.bytes += bytes;
+  stats.wire_us += bytes * 8 * 1e6 / clock_hz + transaction_ns / 1e3;
+}
+
+void ili9341_host_connect(GPIO_TypeDef* cs_port, uint16_t cs_pin, GPIO_TypeDef* dc_port, uint16_t dc_pin,
+    GPIO_TypeDef* reset_port, uint16_t reset_pin) {
+  cs = (host_pin_t) { cs_port, cs_pin };
+  dc = (host_pin_t) { dc_port, dc_pin };
+  reset = (host_pin_t) { reset_port, reset_pin };
+  reset_controller();
+}
+
+void ili9341_host_set_clock(uint32_t hz, uint32_t ns) {
+  clock_hz = hz;
+  transaction_ns = ns;
+}
+
+void ili9341_host_reset_stats(void) {
+  memset(&stats, 0, sizeof(stats));
+}
+
+void ili9341_host_get_stats(ili9341_host_stats_t* out) {
+  *out = stats;
+}
+
+void ili9341_host_pin(GPIO_TypeDef* port, uint16_t pin, bool set) {
+  if (port == cs.port && pin == cs.pin) {
+    if (selected == !set) {
+      return;
+    }
+    selected = !set;
+    stats.cs_toggles++;
+    // The serial interface starts over at the next selection.
+    if (!selected && half_pixel) {
+      stats.errors++;
+      half_pixel = false;
+    }
+  }
+  else if (port == dc.port && pin == dc.pin) {
+    if (data_mode != set) {
+      data_mode = set;
+      stats.dc_toggles++;
+    }
+  }
+  else if (port == reset.port && pin == reset.pin && !set) {
+    reset_controller();
+  }
+}
+
+void ili9341_host_transfer_bytes(const uint8_t* data, uint32_t count, bool increment) {
+  count_transaction(count);
+  for (uint32_t i = 0; i < count; i++) {
+    receive(data[increment ? i : 0]);
+  }
+}
+
+void ili9341_host_transfer_words(const uint16_t* data, uint32_t count, bool increment) {
+  count_transaction(2 * (uint64_t) count);
+  for (uint32_t i = 0; i < count; i++) {
+    uint16_t word = data[increment ? i : 0];
+    receive(word >> 8);
+    receive(word & 0xFF);
+  }
+}
+
+uint16_t ili9341_host_screen_width(void) {
+  return madctl & MADCTL_MV ? ILI9341_HOST_HEIGHT : ILI9341_HOST_WIDTH;
+}
+
+uint16_t ili9341_host_screen_height(void) {
+  return madctl & MADCTL_MV ? ILI9341_HOST_WIDTH : ILI9341_HOST_HEIGHT;
+}
+
+uint16_t ili9341_host_screen_pixel(uint16_t x, uint16_t y) {
+  uint16_t memory_column, memory_line;
+  if (!map_address(x, y, &memory_column, &memory_line)) {
+    return 0;
+  }
+  return memory[scrolled_line(memory_line)][memory_column];
+}
+
+uint32_t ili9341_host_checksum(void) {
+  uint32_t hash = 2166136261U;
+  for (uint16_t y = 0; y < ili9341_host_screen_height(); y++) {
+    for (uint16_t x = 0; x < ili9341_host_screen_width(); x++) {
+      uint16_t color = ili9341_host_screen_pixel(x, y);
+      hash = (hash ^ (color >> 8)) * 16777619U;
+      hash = (hash ^ (color & 0xFF)) * 16777619U;
+    }
+  }
+  return hash;
+}
+
+bool ili9341_host_write_ppm(const char* path) {
+  FILE* file = fopen(path, "wb");
+  if (file == NULL) {
+    return false;
+  }
+  uint16_t width = ili9341_host_screen_width(), height = ili9341_host_screen_height();
+  fprintf(file, "P6\n%d %d\n255\n", width, height);
+  for (uint16_t y = 0; y < height; y++) {
+    for (uint16_t x = 0; x < width; x++) {
+      uint16_t color = ili9341_host_screen_pixel(x, y);
+      uint8_t red = color >> 11, green = (color >> 5) & 0x3F, blue = color & 0x1F;
+      fputc(red << 3 | red >> 2, file);
+      fputc(green << 2 | green >> 4, file);
+      fputc(blue << 3 | blue >> 2, file);
+    }
+  }
+  return fclose(file) == 0;
+}
@@ -0,0 +1,66 @@
+/*
+ * ili9341_host.h
+ *
+ * Host back-end of the ILI9341 driver. The HAL calls and the register level
+ * writes of the driver end up on a model of the SPI bus and the panel: the
+ * bytes are decoded like the controller does (commands, address window, pixel
+ * writes, memory access control and vertical scrolling) into its frame memory,
+ * and every transfer is counted, with the time it would take on the wire.
+ */
+
+#ifndef ILI9341_HOST_H_
+#define ILI9341_HOST_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "stm32l4xx_hal.h"
+
+#define ILI9341_HOST_WIDTH 240  // the frame memory, in portrait
+#define ILI9341_HOST_HEIGHT 320
+
+typedef struct {
+  uint64_t bytes;         // on the wire, to whichever device is selected
+  uint64_t transactions;  // bursts: a register level write, a blocking HAL transfer or a DMA transfer
+  uint64_t cs_toggles;    // edges of the TFT chip select
+  uint64_t dc_toggles;    // edges of the data/command line
+  uint64_t commands;      // command bytes received by the TFT
+  uint64_t pixels;        // pixels written into the frame memory
+  uint64_t errors;        // half a pixel left when CS is released or a command follows
+  double wire_us;         // modelled time of the transfers, see ili9341_host_set_clock()
+} ili9341_host_stats_t;
+
+// The pins the TFT is wired to, its bus is the SPI everything goes through.
+void ili9341_host_connect(GPIO_TypeDef* cs_port, uint16_t cs_pin, GPIO_TypeDef* dc_port, uint16_t dc_pin,
+    GPIO_TypeDef* reset_port, uint16_t reset_pin);
+
+// The wire time of a transaction is its bits at the SPI clock, plus a fixed cost for setting it up.
+void ili9341_host_set_clock(uint32_t clock_hz, uint32_t transaction_ns);
+
+void ili9341_host_reset_stats(void);
+void ili9341_host_get_stats(ili9341_host_stats_t* stats);
+
+// Called by the GPIO shim on every write of a pin.
+void ili9341_host_pin(GPIO_TypeDef* port, uint16_t pin, bool set);
+
+// A transaction of bytes, or of 16 bit frames sent MSB first. Without increment the first one is repeated.
+void ili9341_host_transfer_bytes(const uint8_t* data, uint32_t count, bool increment);
+void ili9341_host_transfer_words(const uint16_t* data, uint32_t count, bool increment);
+
+// The pixel shown at (x, y) of the screen, in the orientation and scroll state the driver last set.
+uint16_t ili9341_host_screen_pixel(uint16_t x, uint16_t y);
+uint16_t ili9341_host_screen_width(void);
+uint16_t ili9341_host_screen_height(void);
+
+// FNV-1a of the screen as shown, to tell whether a change of the driver changed the image.
+uint32_t ili9341_host_checksum(void);
+
+// Writes the screen as shown into a binary PPM. Returns false if the file can't be written.
+bool ili9341_host_write_ppm(const char* path);
+
+// The HAL shims (hal_host.c): the tick is moved by the caller, and the ADC DMA buffer is the one the application
+// started the conversions into.
+void hal_host_advance(uint32_t ms);
+uint16_t* hal_host_adc_buffer(uint32_t* length);
+
+#endif /* ILI9341_HOST_H_ */
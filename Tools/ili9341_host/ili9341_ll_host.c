@@ -0,0 +1,39 @@
+/*
+ * ili9341_ll_host.c
+ *
+ * Host bus back-end of Core/Src/ili9341_ll.c, in place of the SPI one of the
+ * target (Core/Src/ili9341_ll_spi.c). The register writes of the target can't
+ * be observed on a PC, so the bytes go to the bus model, one transaction per
+ * write as there, and D/C is set through the GPIO shim. The commands and the
+ * address window cache are the ones of the target.
+ */
+
+// ----------------------------------------------------------------- includes --
+
+#include "ili9341_ll.h"
+#include "ili9341_host.h"
+
+// ------------------------------------------------------- exported functions --
+
+void ili9341_ll_transmit(ili9341_t *lcd,
+    GPIO_PinState data_command, uint16_t data_sz, uint8_t const data[])
+{
+  HAL_GPIO_WritePin(lcd->data_command_port, lcd->data_command_pin, data_command);
+  ili9341_ll_set_frame_size(lcd, SPI_DATASIZE_8BIT);
+  ili9341_host_transfer_bytes(data, data_sz, ibTrue);
+}
+
+void ili9341_ll_set_frame_size(ili9341_t *lcd, uint32_t data_size)
+{
+  // the HAL shim reads the frame size from the handle, as the HAL does
+  lcd->spi_hal->Init.DataSize = data_size;
+}
+
+void ili9341_ll_set_dma_source(ili9341_t *lcd, ili9341_bool_t increment)
+{
+  DMA_HandleTypeDef *dma = lcd->spi_hal->hdmatx;
+
+  dma->Init.MemInc              = ibOK(increment) ? DMA_MINC_ENABLE : DMA_MINC_DISABLE;
+  dma->Init.PeriphDataAlignment = DMA_PDATAALIGN_HALFWORD;
+  dma->Init.MemDataAlignment    = DMA_MDATAALIGN_HALFWORD;
+}
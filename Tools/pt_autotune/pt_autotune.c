@@ -0,0 +1,416 @@
+/*
+ * pt_autotune.c
+ *
+ * Host tool that searches the parameter space of the Pan-Tompkins detector in
+ * Core/Src/signal_processing.c over a corpus of annotated recordings, and
+ * reports the Pareto front of sensitivity, positive predictivity and cost.
+ *
+ * A record is given by its base name and consists of two plain text files:
+ *   <record>.txt  ADC samples (ADC_SAMPLE_BITS wide) at SAMPLING_FREQUENCY, one
+ *                 integer per line
+ *   <record>.ann  sample indices of the reference R-peaks, one per line
+ *
+ * The detector parameters are globals, so candidates are evaluated in forked
+ * worker processes (one per core by default) instead of threads.
+ *
+ * All the parameters of pt_params_t are searched except rr_miss_limit, which is
+ * inert: only the back search reads it, and the back search is disabled. It
+ * keeps its default, otherwise the candidates differing only in it would score
+ * the same and all be printed on the Pareto front.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include "signal_processing.h"
+
+#define DEFAULT_TOLERANCE_MS 150 // ANSI/AAMI EC57 beat matching window
+#define DEFAULT_LATENCY 22       // detection delay of the filter chain, in samples
+#define DEFAULT_CANDIDATES 256
+#define GRID_LEVELS 3
+#define GRID_PARAMS 7
+
+typedef struct {
+  char* name;
+  uint16_t* samples;
+  uint32_t sample_count;
+  uint32_t* peaks;
+  uint32_t peak_count;
+} record_t;
+
+typedef struct {
+  uint32_t candidate;
+  uint32_t true_positives;
+  uint32_t false_positives;
+  uint32_t false_negatives;
+  double ns_per_sample;
+} score_t;
+
+// Parameter levels used by the grid search.
+static const float GRID[GRID_PARAMS][GRID_LEVELS] = {
+  {0.0625f, 0.125f, 0.25f}, // peak_weight
+  {0.125f, 0.25f, 0.375f},  // threshold_fraction
+  {20, 30, 40},             // window_size
+  {0.88f, 0.92f, 0.96f},    // rr_low_limit
+  {1.08f, 1.16f, 1.24f},    // rr_high_limit
+  {0, 3, 7},                // rr_intervals_to_skip
+  {200, 400, 600},          // learning_samples
+};
+
+// Parameter ranges used by the random search.
+static const float RANGE[GRID_PARAMS][2] = {
+  {0.05f, 0.3f},
+  {0.1f, 0.5f},
+  {16, 44},
+  {0.8f, 1.0f},
+  {1.0f, 1.4f},
+  {0, 8},
+  {200, 600},
+};
+
+static record_t* records;
+static uint32_t record_count;
+static pt_params_t* candidates;
+static uint32_t candidate_count;
+static uint32_t tolerance;
+static uint32_t latency;
+static uint32_t evaluation_start;
+
+static void usage(const char* program) {
+  fprintf(stderr,
+      "usage: %s [-g | -n candidates] [-j jobs] [-s seed] [-t tolerance_ms]\n"
+      "          [-l latency_samples] [-e start_s] [-v] record...\n"
+      "  -g  grid search over %d levels of each parameter\n"
+      "  -n  random search with the given number of candidates (default %d)\n"
+      "  -j  number of worker processes (default: number of cores)\n"
+      "  -s  seed of the random search\n"
+      "  -t  beat matching tolerance (default %d ms)\n"
+      "  -l  detection latency subtracted before matching (default %d samples)\n"
+      "  -e  ignore reference beats before this time (default 0 s)\n"
+      "  -v  print every candidate, not only the Pareto front\n",
+      program, GRID_LEVELS, DEFAULT_CANDIDATES, DEFAULT_TOLERANCE_MS, DEFAULT_LATENCY);
+  exit(2);
+}
+
+static uint32_t* read_values(const char* path, uint32_t* count) {
+  FILE* file = fopen(path, "r");
+  if (file == NULL) {
+    fprintf(stderr, "cannot open %s: %s\n", path, strerror(errno));
+    exit(1);
+  }
+  uint32_t capacity = 4096, n = 0;
+  uint32_t* values = malloc(capacity * sizeof(uint32_t));
+  long value;
+  while (fscanf(file, "%ld", &value) == 1) {
+    if (n == capacity) {
+      capacity *= 2;
+      values = realloc(values, capacity * sizeof(uint32_t));
+    }
+    values[n++] = (uint32_t) value;
+  }
+  fclose(file);
+  *count = n;
+  return values;
+}
+
+static void load_record(record_t* record, char* name) {
+  char path[4096];
+  uint32_t* values;
+
+  record->name = name;
+  snprintf(path, sizeof(path), "%s.txt", name);
+  values = read_values(path, &record->sample_count);
+  record->samples = malloc(record->sample_count * sizeof(uint16_t) + 1);
+  for (uint32_t i = 0; i < record->sample_count; i++) {
+    record->samples[i] = (uint16_t) values[i];
+  }
+  free(values);
+
+  snprintf(path, sizeof(path), "%s.ann", name);
+  record->peaks = read_values(path, &record->peak_count);
+}
+
+static float random_between(uint64_t* state, float low, float high) {
+  // xorshift64*, good enough and reproducible across platforms
+  *state ^= *state >> 12;
+  *state ^= *state << 25;
+  *state ^= *state >> 27;
+  uint64_t r = *state * 0x2545F4914F6CDD1DULL;
+  return low + (high - low) * (float) ((r >> 11) * (1.0 / 9007199254740992.0));
+}
+
+static pt_params_t params_from_values(const float values[GRID_PARAMS]) {
+  pt_params_t p = PT_DEFAULT_PARAMS;
+  p.peak_weight = values[0];
+  p.threshold_fraction = values[1];
+  p.window_size = (uint16_t) (values[2] + 0.5f);
+  p.rr_low_limit = values[3];
+  p.rr_high_limit = values[4];
+  p.rr_intervals_to_skip = (uint16_t) (values[5] + 0.5f);
+  p.learning_samples = (uint16_t) (values[6] + 0.5f);
+  return p;
+}
+
+static void build_grid() {
+  uint32_t grid_size = 1;
+  for (int p = 0; p < GRID_PARAMS; p++) {
+    grid_size *= GRID_LEVELS;
+  }
+  // candidate 0 is always the current detector, as a reference
+  candidate_count = grid_size + 1;
+  candidates = malloc(candidate_count * sizeof(pt_params_t));
+  candidates[0] = PT_DEFAULT_PARAMS;
+  for (uint32_t c = 0; c < grid_size; c++) {
+    float values[GRID_PARAMS];
+    uint32_t digits = c;
+    for (int p = 0; p < GRID_PARAMS; p++) {
+      values[p] = GRID[p][digits % GRID_LEVELS];
+      digits /= GRID_LEVELS;
+    }
+    candidates[c + 1] = params_from_values(values);
+  }
+}
+
+static void build_random(uint32_t count, uint64_t seed) {
+  uint64_t state = seed != 0 ? seed : 0x9E3779B97F4A7C15ULL;
+  candidate_count = count;
+  candidates = malloc(candidate_count * sizeof(pt_params_t));
+  candidates[0] = PT_DEFAULT_PARAMS;
+  for (uint32_t c = 1; c < candidate_count; c++) {
+    float values[GRID_PARAMS];
+    for (int p = 0; p < GRID_PARAMS; p++) {
+      values[p] = random_between(&state, RANGE[p][0], RANGE[p][1]);
+    }
+    candidates[c] = params_from_values(values);
+  }
+}
+
+static double cpu_time_ns() {
+  struct timespec ts;
+  clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+// Matches detections against the reference beats of a record, both lists being sorted.
+static void match_beats(const record_t* record, const uint32_t* detections, uint32_t detection_count,
+    score_t* score) {
+  uint32_t a = 0, d = 0, tp = 0, fp = 0, fn = 0;
+
+  while (a < record->peak_count && record->peaks[a] < evaluation_start) {
+    a++;
+  }
+  while (d < detection_count && detections[d] < evaluation_start + latency) {
+    d++;
+  }
+  while (a < record->peak_count && d < detection_count) {
+    int64_t difference = (int64_t) detections[d] - latency - record->peaks[a];
+    if (difference < -(int64_t) tolerance) {
+      fp++;
+      d++;
+    }
+    else if (difference > (int64_t) tolerance) {
+      fn++;
+      a++;
+    }
+    else {
+      tp++;
+      a++;
+      d++;
+    }
+  }
+  fn += record->peak_count - a;
+  fp += detection_count - d;
+
+  score->true_positives += tp;
+  score->false_positives += fp;
+  score->false_negatives += fn;
+}
+
+static void evaluate(uint32_t candidate, score_t* score) {
+  static uint16_t signal[BUFFER_SIZE];
+  static float filtered[BUFFER_SIZE];
+  static pt_detector_t detector;
+  double elapsed = 0;
+  uint64_t samples = 0;
+
+  memset(score, 0, sizeof(*score));
+  score->candidate = candidate;
+  set_pan_tompkins_params(&candidates[candidate]);
+
+  for (uint32_t r = 0; r < record_count; r++) {
+    const record_t* record = &records[r];
+    uint32_t* detections = malloc((record->sample_count + 1) * sizeof(uint32_t));
+    uint32_t detection_count = 0;
+    pt_result_t result = {0};
+
+    reset_pan_tompkins(&detector);
+    double start = cpu_time_ns();
+    for (uint32_t i = 0; i < record->sample_count; i++) {
+      signal[i % BUFFER_SIZE] = record->samples[i];
+      process_pan_tompkins(&detector, signal, filtered, i, &result);
+      if (result.is_qrs) {
+        detections[detection_count++] = i;
+      }
+    }
+    elapsed += cpu_time_ns() - start;
+    samples += record->sample_count;
+
+    match_beats(record, detections, detection_count, score);
+    free(detections);
+  }
+  score->ns_per_sample = samples > 0 ? elapsed / samples : 0;
+}
+
+static double sensitivity(const score_t* s) {
+  uint32_t total = s->true_positives + s->false_negatives;
+  return total > 0 ? 100.0 * s->true_positives / total : 0;
+}
+
+static double predictivity(const score_t* s) {
+  uint32_t total = s->true_positives + s->false_positives;
+  return total > 0 ? 100.0 * s->true_positives / total : 0;
+}
+
+static int dominates(const score_t* a, const score_t* b) {
+  double se_a = sensitivity(a), se_b = sensitivity(b);
+  double p_a = predictivity(a), p_b = predictivity(b);
+  if (se_a < se_b || p_a < p_b || a->ns_per_sample > b->ns_per_sample) {
+    return 0;
+  }
+  return se_a > se_b || p_a > p_b || a->ns_per_sample < b->ns_per_sample;
+}
+
+static int by_sensitivity(const void* a, const void* b) {
+  double d = sensitivity((const score_t*) b) - sensitivity((const score_t*) a);
+  return d < 0 ? -1 : d > 0 ? 1 : 0;
+}
+
+static void print_score(const score_t* s) {
+  const pt_params_t* p = &candidates[s->candidate];
+  printf("%7.2f %7.2f %9.1f   %6.4f %6.4f %4u %6.3f %6.3f %4u %6u%s\n",
+      sensitivity(s), predictivity(s), s->ns_per_sample,
+      p->peak_weight, p->threshold_fraction, p->window_size,
+      p->rr_low_limit, p->rr_high_limit,
+      p->rr_intervals_to_skip, p->learning_samples,
+      s->candidate == 0 ? "  (default)" : "");
+}
+
+static void run_worker(uint32_t worker, uint32_t jobs, int fd) {
+  for (uint32_t c = worker; c < candidate_count; c += jobs) {
+    score_t score;
+    evaluate(c, &score);
+    if (write(fd, &score, sizeof(score)) != sizeof(score)) {
+      _exit(1);
+    }
+  }
+  _exit(0);
+}
+
+int main(int argc, char* argv[]) {
+  int grid = 0, verbose = 0, option;
+  long jobs = sysconf(_SC_NPROCESSORS_ONLN);
+  uint32_t count = DEFAULT_CANDIDATES;
+  uint64_t seed = 0;
+  uint32_t tolerance_ms = DEFAULT_TOLERANCE_MS;
+  double start_s = 0;
+
+  latency = DEFAULT_LATENCY;
+  while ((option = getopt(argc, argv, "gn:j:s:t:l:e:v")) != -1) {
+    switch (option) {
+      case 'g': grid = 1; break;
+      case 'n': count = strtoul(optarg, NULL, 0); break;
+      case 'j': jobs = strtol(optarg, NULL, 0); break;
+      case 's': seed = strtoull(optarg, NULL, 0); break;
+      case 't': tolerance_ms = strtoul(optarg, NULL, 0); break;
+      case 'l': latency = strtoul(optarg, NULL, 0); break;
+      case 'e': start_s = strtod(optarg, NULL); break;
+      case 'v': verbose = 1; break;
+      default: usage(argv[0]);
+    }
+  }
+  if (optind >= argc || count < 1) {
+    usage(argv[0]);
+  }
+  if (jobs < 1) {
+    jobs = 1;
+  }
+  tolerance = tolerance_ms * SAMPLING_FREQUENCY / 1000;
+  evaluation_start = (uint32_t) (start_s * SAMPLING_FREQUENCY);
+
+  record_count = argc - optind;
+  records = calloc(record_count, sizeof(record_t));
+  for (uint32_t r = 0; r < record_count; r++) {
+    load_record(&records[r], argv[optind + r]);
+  }
+
+  if (grid) {
+    build_grid();
+  }
+  else {
+    build_random(count, seed);
+  }
+  if (jobs > (long) candidate_count) {
+    jobs = candidate_count;
+  }
+  fprintf(stderr, "evaluating %u candidates on %u records with %ld workers\n",
+      candidate_count, record_count, jobs);
+
+  // Every worker evaluates an interleaved share of the candidates and streams
+  // its scores back through a pipe.
+  int* fds = malloc(jobs * sizeof(int));
+  pid_t* pids = malloc(jobs * sizeof(pid_t));
+  for (long w = 0; w < jobs; w++) {
+    int pipe_fds[2];
+    if (pipe(pipe_fds) != 0) {
+      perror("pipe");
+      return 1;
+    }
+    pids[w] = fork();
+    if (pids[w] < 0) {
+      perror("fork");
+      return 1;
+    }
+    if (pids[w] == 0) {
+      close(pipe_fds[0]);
+      run_worker(w, jobs, pipe_fds[1]);
+    }
+    close(pipe_fds[1]);
+    fds[w] = pipe_fds[0];
+  }
+
+  score_t* scores = malloc(candidate_count * sizeof(score_t));
+  uint32_t received = 0;
+  for (long w = 0; w < jobs; w++) {
+    score_t score;
+    while (read(fds[w], &score, sizeof(score)) == sizeof(score)) {
+      scores[received++] = score;
+    }
+    close(fds[w]);
+    waitpid(pids[w], NULL, 0);
+  }
+  if (received != candidate_count) {
+    fprintf(stderr, "only %u of %u candidates were evaluated\n", received, candidate_count);
+    return 1;
+  }
+
+  qsort(scores, candidate_count, sizeof(score_t), by_sensitivity);
+  printf("  Se(%%)   +P(%%) ns/sample   weight  thres  win  rrlow rrhigh skip  learn\n");
+  for (uint32_t a = 0; a < candidate_count; a++) {
+    int dominated = 0;
+    for (uint32_t b = 0; b < candidate_count && !dominated; b++) {
+      dominated = b != a && dominates(&scores[b], &scores[a]);
+    }
+    if (verbose || !dominated) {
+      print_score(&scores[a]);
+    }
+  }
+  return 0;
+}
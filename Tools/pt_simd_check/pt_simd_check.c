@@ -0,0 +1,148 @@
+/*
+ * pt_simd_check.c
+ *
+ * Host tool that checks the template matching of Core/Src/beat_template.c,
+ * whose sums are taken with SMLAD, against a double precision Pearson
+ * correlation: on random beats the same alignment has to be picked, by the
+ * largest |r|, with the same score. An inverted ventricular beat has to be
+ * matched at its most negative alignment, and not fall in the noise band.
+ *
+ * On a PC the DSP instructions are emulated by Core/Inc/dsp_simd.h, so this
+ * checks the kernel and the emulation, the instructions themselves are the
+ * ones of the target.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <math.h>
+
+#include "beat_template.h"
+
+#define DEFAULT_BEATS 2000       // random beats matched against the template
+#define TEMPLATE_TOLERANCE 0.001 // of the score, the kernel divides in single precision
+
+static double random_unit(uint64_t* state) {
+  // xorshift64*, good enough and reproducible across platforms
+  *state ^= *state >> 12;
+  *state ^= *state << 25;
+  *state ^= *state >> 27;
+  uint64_t r = *state * 0x2545F4914F6CDD1DULL;
+  return (double) (r >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static void usage(const char* program) {
+  fprintf(stderr,
+      "usage: %s [-n beats] [-s seed]\n"
+      "  -n  number of random beats (default %d)\n"
+      "  -s  seed of the beat generator\n",
+      program, DEFAULT_BEATS);
+  exit(2);
+}
+
+// A QRS complex in the segment of a beat, in DC blocked counts shifted by TEMPLATE_SAMPLE_SHIFT: a Q, R and S wave
+// centered on the R peak of the segment plus offset, stretched by width.
+static void generate_beat(int16_t* segment, double amplitude, double offset, double width, double noise,
+    uint64_t* state) {
+  static const struct {
+    double at, width, amplitude;
+  } WAVES[] = { { -4, 1.5, -0.15 }, { 0, 1.8, 1 }, { 4, 2, -0.3 } };
+  for (int32_t i = 0; i < TEMPLATE_SEGMENT_LENGTH; i++) {
+    double t = i - TEMPLATE_MAX_SHIFT - TEMPLATE_BEFORE_R - offset, value = 0;
+    for (size_t w = 0; w < sizeof(WAVES) / sizeof(WAVES[0]); w++) {
+      double d = (t - WAVES[w].at * width) / (WAVES[w].width * width);
+      value += WAVES[w].amplitude * exp(-d * d / 2);
+    }
+    segment[i] = (int16_t) lround(amplitude * value + noise * (random_unit(state) - 0.5));
+  }
+}
+
+// Pearson correlation of the template with the window of the segment at a shift.
+static double reference_score(const pt_beat_template_t* beat_template, const int16_t* segment, int8_t shift) {
+  const int16_t* window = segment + TEMPLATE_MAX_SHIFT + shift;
+  double sx = 0, sy = 0, sxx = 0, syy = 0, sxy = 0;
+  for (uint8_t i = 0; i < TEMPLATE_LENGTH; i++) {
+    double x = window[i], y = beat_template->samples[i];
+    sx += x;
+    sy += y;
+    sxx += x * x;
+    syy += y * y;
+    sxy += x * y;
+  }
+  double variance_x = TEMPLATE_LENGTH * sxx - sx * sx, variance_y = TEMPLATE_LENGTH * syy - sy * sy;
+  return variance_x > 0 && variance_y > 0 ? (TEMPLATE_LENGTH * sxy - sx * sy) / sqrt(variance_x * variance_y) : 0;
+}
+
+static int check_template(uint32_t beats, uint64_t* state) {
+  static pt_beat_template_t beat_template;
+  int16_t segment[TEMPLATE_SEGMENT_LENGTH];
+  pt_template_match_t match;
+  int failures = 0;
+
+  // The dominant beat, averaged from noisy beats as the detector does.
+  reset_beat_template(&beat_template);
+  for (uint8_t i = 0; i < 16; i++) {
+    generate_beat(segment, 400, 0, 1, 20, state);
+    match_beat_template(&beat_template, segment, &match);
+    update_beat_template(&beat_template, segment, &match);
+  }
+
+  for (uint32_t n = 0; n < beats && failures < 10; n++) {
+    double amplitude = (random_unit(state) < 0.5 ? -1 : 1) * (50 + 1500 * random_unit(state));
+    generate_beat(segment, amplitude, 4 * random_unit(state) - 2, 0.7 + random_unit(state), 200 * random_unit(state),
+        state);
+    match_beat_template(&beat_template, segment, &match);
+    double best = 0;
+    int8_t best_shift = 0;
+    for (int8_t shift = -TEMPLATE_MAX_SHIFT; shift <= TEMPLATE_MAX_SHIFT; shift++) {
+      double score = reference_score(&beat_template, segment, shift);
+      if (fabs(score) > fabs(best)) {
+        best = score;
+        best_shift = shift;
+      }
+    }
+    // Where two alignments score within the tolerance, either one will do.
+    double kernel_score = (double) match.score / TEMPLATE_SCORE_ONE;
+    double at_kernel_shift = reference_score(&beat_template, segment, match.shift);
+    if (fabs(kernel_score - best) > TEMPLATE_TOLERANCE || fabs(at_kernel_shift - best) > TEMPLATE_TOLERANCE) {
+      fprintf(stderr, "template beat %u: score %.4f at shift %d, reference %.4f at shift %d\n",
+          n, kernel_score, match.shift, best, best_shift);
+      failures++;
+    }
+  }
+
+  // A ventricular beat: inverted, wide and one sample late.
+  generate_beat(segment, -900, 1, 1.6, 20, state);
+  match_beat_template(&beat_template, segment, &match);
+  if (match.score > -TEMPLATE_NOISE_SCORE) {
+    fprintf(stderr, "inverted beat: score %.4f at shift %d, taken for noise\n",
+        (double) match.score / TEMPLATE_SCORE_ONE, match.shift);
+    failures++;
+  }
+  printf("%u beats and an inverted one matched against the template (inverted: r = %.3f at shift %d): %s\n",
+      beats, (double) match.score / TEMPLATE_SCORE_ONE, match.shift,
+      failures ? "FAILED" : "the template kernel matches the reference");
+  return failures;
+}
+
+int main(int argc, char** argv) {
+  uint32_t beats = DEFAULT_BEATS;
+  uint64_t seed = 88172645463325252ULL;
+  int option;
+
+  while ((option = getopt(argc, argv, "n:s:")) != -1) {
+    switch (option) {
+      case 'n': beats = strtoul(optarg, NULL, 0); break;
+      case 's': seed = strtoull(optarg, NULL, 0); break;
+      default: usage(argv[0]);
+    }
+  }
+  if (optind != argc || beats < 1) {
+    usage(argv[0]);
+  }
+
+  uint64_t state = seed ? seed : 1;
+  return check_template(beats, &state) ? 1 : 0;
+}